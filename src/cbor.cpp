@@ -0,0 +1,397 @@
+#include "cbor.hpp"
+
+#define FMT_HEADER_ONLY
+
+#include <fmt/format.h>
+#include <cfloat>
+#include <climits>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+using namespace std;
+using namespace njones;
+
+static const uint8_t MAJOR_UINT   = 0;
+static const uint8_t MAJOR_NINT   = 1;
+static const uint8_t MAJOR_BYTES  = 2;
+static const uint8_t MAJOR_TEXT   = 3;
+static const uint8_t MAJOR_ARRAY  = 4;
+static const uint8_t MAJOR_MAP    = 5;
+static const uint8_t MAJOR_TAG    = 6;
+static const uint8_t MAJOR_SIMPLE = 7;
+
+static const uint8_t INFO_INDEFINITE = 31;
+
+static const uint8_t SIMPLE_FALSE     = 20;
+static const uint8_t SIMPLE_TRUE      = 21;
+static const uint8_t SIMPLE_NULL      = 22;
+static const uint8_t SIMPLE_UNDEFINED = 23;
+static const uint8_t SIMPLE_HALF      = 25;
+static const uint8_t SIMPLE_FLOAT     = 26;
+static const uint8_t SIMPLE_DOUBLE    = 27;
+
+static const uint8_t BREAK = 0xFF;
+
+const size_t cbor_encoder::FLUSH_SIZE = 64 * 1024;
+
+cbor_encoder::cbor_encoder() : stream(nullptr), open(0) {
+}
+
+cbor_encoder::cbor_encoder(std::ostream &stream) : stream(&stream), open(0) {
+    buffer.reserve(FLUSH_SIZE);
+}
+
+cbor_encoder::~cbor_encoder() {
+    if (stream != nullptr)
+        flush();
+}
+
+void cbor_encoder::write(const dynamic &d) {
+    switch (d.get_type()) {
+        case dynamic::type::NONE:
+            buffer.push_back(static_cast<char>((MAJOR_SIMPLE << 5) | SIMPLE_NULL));
+            break;
+        case dynamic::type::INT:
+        case dynamic::type::LONG: {
+            long val = d.as_long();
+            if (val < 0)
+                write_head(MAJOR_NINT, static_cast<uint64_t>(-1 - val));
+            else
+                write_head(MAJOR_UINT, static_cast<uint64_t>(val));
+            break;
+        }
+        case dynamic::type::UINT:
+        case dynamic::type::ULONG:
+            write_head(MAJOR_UINT, d.as_ulong());
+            break;
+        case dynamic::type::DOUBLE:
+            write_double(d.as_double());
+            break;
+        case dynamic::type::BOOL:
+            buffer.push_back(
+                static_cast<char>((MAJOR_SIMPLE << 5) | (d.as_bool() ? SIMPLE_TRUE : SIMPLE_FALSE)));
+            break;
+        case dynamic::type::STRING:
+            write_string(d.as_string());
+            break;
+        case dynamic::type::ARRAY:
+            write_head(MAJOR_ARRAY, d.size());
+            for (const auto item : d)
+                write(item.value());
+            break;
+        case dynamic::type::MAP:
+            write_head(MAJOR_MAP, d.size());
+            for (const auto item : d) {
+                write(item.key());
+                write(item.value());
+            }
+            break;
+    }
+    maybe_flush();
+}
+
+void cbor_encoder::begin_array() {
+    buffer.push_back(static_cast<char>((MAJOR_ARRAY << 5) | INFO_INDEFINITE));
+    open++;
+}
+
+void cbor_encoder::begin_array(const size_t size) {
+    write_head(MAJOR_ARRAY, size);
+}
+
+void cbor_encoder::begin_map() {
+    buffer.push_back(static_cast<char>((MAJOR_MAP << 5) | INFO_INDEFINITE));
+    open++;
+}
+
+void cbor_encoder::begin_map(const size_t size) {
+    write_head(MAJOR_MAP, size);
+}
+
+void cbor_encoder::end() {
+    if (open == 0)
+        throw domain_error("cbor encoder has no open indefinite-length container");
+    buffer.push_back(static_cast<char>(BREAK));
+    open--;
+    maybe_flush();
+}
+
+void cbor_encoder::flush() {
+    if (stream == nullptr)
+        return;
+    stream->write(buffer.data(), buffer.size());
+    buffer.clear();
+}
+
+const std::string &cbor_encoder::str() const {
+    return buffer;
+}
+
+void cbor_encoder::write_head(const uint8_t major, const uint64_t val) {
+    const uint8_t m = major << 5;
+    if (val < 24) {
+        buffer.push_back(static_cast<char>(m | val));
+    } else if (val <= 0xFF) {
+        buffer.push_back(static_cast<char>(m | 24));
+        buffer.push_back(static_cast<char>(val));
+    } else if (val <= 0xFFFF) {
+        buffer.push_back(static_cast<char>(m | 25));
+        for (int shift = 8; shift >= 0; shift -= 8)
+            buffer.push_back(static_cast<char>(val >> shift));
+    } else if (val <= 0xFFFFFFFF) {
+        buffer.push_back(static_cast<char>(m | 26));
+        for (int shift = 24; shift >= 0; shift -= 8)
+            buffer.push_back(static_cast<char>(val >> shift));
+    } else {
+        buffer.push_back(static_cast<char>(m | 27));
+        for (int shift = 56; shift >= 0; shift -= 8)
+            buffer.push_back(static_cast<char>(val >> shift));
+    }
+}
+
+void cbor_encoder::write_double(const double val) {
+    // Narrowing a finite double outside the float range is undefined, so only try it when the
+    // value fits or is infinite or NaN.
+    const bool  fits = !std::isfinite(val) || std::fabs(val) <= FLT_MAX;
+    const float f    = fits ? static_cast<float>(val) : 0.0f;
+    if (fits && (static_cast<double>(f) == val || std::isnan(val))) {
+        uint32_t bits;
+        memcpy(&bits, &f, sizeof(bits));
+        buffer.push_back(static_cast<char>((MAJOR_SIMPLE << 5) | SIMPLE_FLOAT));
+        for (int shift = 24; shift >= 0; shift -= 8)
+            buffer.push_back(static_cast<char>(bits >> shift));
+    } else {
+        uint64_t bits;
+        memcpy(&bits, &val, sizeof(bits));
+        buffer.push_back(static_cast<char>((MAJOR_SIMPLE << 5) | SIMPLE_DOUBLE));
+        for (int shift = 56; shift >= 0; shift -= 8)
+            buffer.push_back(static_cast<char>(bits >> shift));
+    }
+}
+
+void cbor_encoder::write_string(const std::string &val) {
+    write_head(MAJOR_TEXT, val.size());
+    buffer.append(val);
+}
+
+void cbor_encoder::maybe_flush() {
+    if (stream != nullptr && buffer.size() >= FLUSH_SIZE)
+        flush();
+}
+
+const size_t cbor_decoder::MAX_DEPTH = 512;
+
+cbor_decoder::cbor_decoder(const uint8_t *data, const size_t size)
+    : data(data), size(size), pos(0) {
+}
+
+cbor_decoder::cbor_decoder(const std::string &data)
+    : data(reinterpret_cast<const uint8_t *>(data.data())), size(data.size()), pos(0) {
+}
+
+cbor_decoder::~cbor_decoder() {
+}
+
+dynamic cbor_decoder::decode() {
+    return decode_item(0);
+}
+
+bool cbor_decoder::done() const {
+    return pos >= size;
+}
+
+dynamic cbor_decoder::decode_item(const size_t depth) {
+    if (depth > MAX_DEPTH)
+        throw domain_error(fmt::format("cbor item nesting exceeds {} levels", MAX_DEPTH));
+
+    const uint8_t initial = read_byte();
+    const uint8_t major   = initial >> 5;
+    const uint8_t info    = initial & 0x1F;
+
+    switch (major) {
+        case MAJOR_UINT: {
+            const uint64_t val = read_uint(info);
+            if (val <= INT_MAX)
+                return dynamic(static_cast<int>(val));
+            if (val <= LONG_MAX)
+                return dynamic(static_cast<long>(val));
+            return dynamic(static_cast<unsigned long>(val));
+        }
+        case MAJOR_NINT: {
+            const uint64_t val = read_uint(info);
+            if (val <= INT_MAX)
+                return dynamic(static_cast<int>(-1 - static_cast<long>(val)));
+            if (val <= LONG_MAX)
+                return dynamic(-1 - static_cast<long>(val));
+            throw domain_error(fmt::format("cbor negative integer -1-{} is out of range", val));
+        }
+        case MAJOR_BYTES:
+        case MAJOR_TEXT: {
+            string s;
+            read_string(major, info, s);
+            return dynamic(s);
+        }
+        case MAJOR_ARRAY: {
+            dynamic ret(dynamic::type::ARRAY);
+            if (info == INFO_INDEFINITE) {
+                while (!at_break())
+                    ret.push_back(decode_item(depth + 1));
+                pos++;
+            } else {
+                const uint64_t count = read_uint(info);
+                if (count > size - pos)
+                    throw range_error(
+                        fmt::format("cbor array of {} items exceeds remaining input", count));
+                ret.reserve(count);
+                for (uint64_t i = 0; i < count; i++)
+                    ret.push_back(decode_item(depth + 1));
+            }
+            return ret;
+        }
+        case MAJOR_MAP: {
+            dynamic ret(dynamic::type::MAP);
+            if (info == INFO_INDEFINITE) {
+                while (!at_break()) {
+                    dynamic key = decode_item(depth + 1);
+                    ret[key]    = decode_item(depth + 1);
+                }
+                pos++;
+            } else {
+                const uint64_t count = read_uint(info);
+                if (count > (size - pos) / 2)
+                    throw range_error(
+                        fmt::format("cbor map of {} pairs exceeds remaining input", count));
+                for (uint64_t i = 0; i < count; i++) {
+                    dynamic key = decode_item(depth + 1);
+                    ret[key]    = decode_item(depth + 1);
+                }
+            }
+            return ret;
+        }
+        case MAJOR_TAG:
+            read_uint(info);
+            return decode_item(depth + 1);
+        default:
+            break;
+    }
+
+    switch (info) {
+        case SIMPLE_FALSE:
+            return dynamic(false);
+        case SIMPLE_TRUE:
+            return dynamic(true);
+        case SIMPLE_NULL:
+        case SIMPLE_UNDEFINED:
+            return dynamic(nullptr);
+        case SIMPLE_HALF:
+            return dynamic(read_half());
+        case SIMPLE_FLOAT: {
+            const uint32_t bits = static_cast<uint32_t>(read_uint(info));
+            float          f;
+            memcpy(&f, &bits, sizeof(f));
+            return dynamic(static_cast<double>(f));
+        }
+        case SIMPLE_DOUBLE: {
+            const uint64_t bits = read_uint(info);
+            double         d;
+            memcpy(&d, &bits, sizeof(d));
+            return dynamic(d);
+        }
+        default:
+            throw domain_error(fmt::format("cbor simple value {} is not supported", info));
+    }
+}
+
+uint8_t cbor_decoder::read_byte() {
+    if (pos >= size)
+        throw range_error("cbor input is truncated");
+    return data[pos++];
+}
+
+uint64_t cbor_decoder::read_uint(const uint8_t info) {
+    if (info < 24)
+        return info;
+
+    size_t len;
+    switch (info) {
+        case 24:
+            len = 1;
+            break;
+        case 25:
+            len = 2;
+            break;
+        case 26:
+            len = 4;
+            break;
+        case 27:
+            len = 8;
+            break;
+        default:
+            throw domain_error(fmt::format("cbor additional information {} is malformed", info));
+    }
+
+    if (size - pos < len)
+        throw range_error("cbor input is truncated");
+
+    uint64_t val = 0;
+    for (size_t i = 0; i < len; i++)
+        val = (val << 8) | data[pos++];
+    return val;
+}
+
+double cbor_decoder::read_half() {
+    const uint16_t half = static_cast<uint16_t>(read_uint(25));
+    const int      exp  = (half >> 10) & 0x1F;
+    const int      mant = half & 0x3FF;
+
+    double val;
+    if (exp == 0)
+        val = ldexp(mant, -24);
+    else if (exp != 31)
+        val = ldexp(mant + 1024, exp - 25);
+    else
+        val = mant == 0 ? INFINITY : NAN;
+    return (half & 0x8000) ? -val : val;
+}
+
+void cbor_decoder::read_string(const uint8_t major, const uint8_t info, std::string &out) {
+    if (info == INFO_INDEFINITE) {
+        while (!at_break()) {
+            const uint8_t chunk = read_byte();
+            if ((chunk >> 5) != major || (chunk & 0x1F) == INFO_INDEFINITE)
+                throw domain_error("cbor indefinite-length string has a malformed chunk");
+            read_string(major, chunk & 0x1F, out);
+        }
+        pos++;
+        return;
+    }
+
+    const uint64_t len = read_uint(info);
+    if (len > size - pos)
+        throw range_error("cbor input is truncated");
+    out.append(reinterpret_cast<const char *>(data + pos), len);
+    pos += len;
+}
+
+bool cbor_decoder::at_break() {
+    if (pos >= size)
+        throw range_error("cbor input is truncated");
+    return data[pos] == BREAK;
+}
+
+std::string cbor::encode(const dynamic &d) {
+    cbor_encoder encoder;
+    encoder.write(d);
+    return encoder.str();
+}
+
+dynamic cbor::decode(const std::string &data) {
+    cbor_decoder decoder(data);
+    return decoder.decode();
+}
+
+dynamic cbor::decode(const uint8_t *data, const size_t size) {
+    cbor_decoder decoder(data, size);
+    return decoder.decode();
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+#include "dynamic.hpp"
+
+namespace njones {
+    class cbor_encoder {
+       public:
+        cbor_encoder();
+        cbor_encoder(std::ostream &stream);
+        ~cbor_encoder();
+
+        void write(const dynamic &d);
+
+        void begin_array();
+        void begin_array(const size_t size);
+        void begin_map();
+        void begin_map(const size_t size);
+        void end();
+
+        void flush();
+
+        const std::string &str() const;
+
+       private:
+        static const size_t FLUSH_SIZE;
+
+        std::string   buffer;
+        std::ostream *stream;
+        size_t        open;
+
+        void write_head(const uint8_t major, const uint64_t val);
+        void write_double(const double val);
+        void write_string(const std::string &val);
+        void maybe_flush();
+    };
+
+    class cbor_decoder {
+       public:
+        cbor_decoder(const uint8_t *data, const size_t size);
+        cbor_decoder(const std::string &data);
+        ~cbor_decoder();
+
+        dynamic decode();
+
+        bool done() const;
+
+       private:
+        static const size_t MAX_DEPTH;
+
+        const uint8_t *data;
+        size_t         size;
+        size_t         pos;
+
+        dynamic  decode_item(const size_t depth);
+        uint8_t  read_byte();
+        uint64_t read_uint(const uint8_t info);
+        double   read_half();
+        void     read_string(const uint8_t major, const uint8_t info, std::string &out);
+        bool     at_break();
+    };
+
+    class cbor {
+       public:
+        static std::string encode(const dynamic &d);
+        static dynamic     decode(const std::string &data);
+        static dynamic     decode(const uint8_t *data, const size_t size);
+    };
+}  // namespace njones
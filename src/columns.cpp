@@ -0,0 +1,163 @@
+#include "dynamic.hpp"
+
+#define FMT_HEADER_ONLY
+
+#include <fmt/format.h>
+#include <stdexcept>
+
+#include "parallel.hpp"
+
+using namespace std;
+using namespace njones;
+
+static size_t column_workers() {
+    return thread_pool::shared().size() + 1;
+}
+
+static const size_t ROW_GRAIN = 4096;
+
+template <class T>
+static dynamic packed_column(const vector<T> &values) {
+    dynamic ret(dynamic::type::ARRAY);
+    ret.assign(values.data(), values.size());
+    return ret;
+}
+
+dynamic dynamic::to_columns() const {
+    type_check(type::ARRAY);
+    const size_t   rows  = size();
+    const dynamic *items = data();
+
+    vector<dynamic>                keys;
+    unordered_map<dynamic, size_t> index;
+    for (size_t i = 0; i < rows; i++) {
+        if (!items[i].is_map())
+            throw domain_error(fmt::format("dynamic value row {} is not a map", i));
+        for (const auto item : items[i]) {
+            const dynamic key = item.key();
+            if (index.find(key) != index.end())
+                continue;
+            index.emplace(key, keys.size());
+            keys.push_back(key);
+        }
+    }
+
+    const size_t            width  = keys.size();
+    const size_t            chunks = (rows + ROW_GRAIN - 1) / ROW_GRAIN;
+    vector<const dynamic *> lookups(rows * width);
+    thread_pool::shared().run(chunks, column_workers(), [&](size_t chunk) {
+        for (size_t i = chunk * ROW_GRAIN; i < std::min((chunk + 1) * ROW_GRAIN, rows); i++)
+            for (size_t c = 0; c < width; c++)
+                lookups[c * rows + i] = items[i].lookup(keys[c]);
+    });
+
+    vector<dynamic> columns(width, dynamic(type::NONE));
+    vector<dynamic> nulls(width, dynamic(type::NONE));
+    thread_pool::shared().run(width, column_workers(), [&](size_t c) {
+        const dynamic *const *cells   = lookups.data() + c * rows;
+        vector<long>          bitmap((rows + 63) / 64, 0);
+        bool                  missing = false;
+        bool                  uniform = true;
+        const dynamic *       first   = nullptr;
+        for (size_t i = 0; i < rows; i++) {
+            if (cells[i] == nullptr) {
+                bitmap[i / 64] |= static_cast<long>(1UL << (i % 64));
+                missing = true;
+            } else if (first == nullptr)
+                first = cells[i];
+            else if (cells[i]->get_type() != first->get_type())
+                uniform = false;
+        }
+
+        const type t = first == nullptr ? type::NONE : first->get_type();
+        if (uniform && t == type::DOUBLE) {
+            vector<double> values(rows, 0.0);
+            for (size_t i = 0; i < rows; i++)
+                if (cells[i] != nullptr)
+                    values[i] = cells[i]->as_double();
+            columns[c] = packed_column(values);
+        } else if (uniform && t == type::INT) {
+            vector<int> values(rows, 0);
+            for (size_t i = 0; i < rows; i++)
+                if (cells[i] != nullptr)
+                    values[i] = cells[i]->as_int();
+            columns[c] = packed_column(values);
+        } else if (uniform && t == type::LONG) {
+            vector<long> values(rows, 0);
+            for (size_t i = 0; i < rows; i++)
+                if (cells[i] != nullptr)
+                    values[i] = cells[i]->as_long();
+            columns[c] = packed_column(values);
+        } else {
+            dynamic column(type::ARRAY);
+            column.reserve(rows);
+            for (size_t i = 0; i < rows; i++)
+                column.push_back(cells[i] != nullptr ? *cells[i] : dynamic(type::NONE));
+            columns[c] = column;
+        }
+
+        if (missing)
+            nulls[c] = packed_column(bitmap);
+    });
+
+    dynamic column_map(type::MAP);
+    dynamic null_map(type::MAP);
+    for (size_t c = 0; c < width; c++) {
+        column_map.insert_or_assign(keys[c], columns[c]);
+        if (nulls[c].is_array())
+            null_map.insert_or_assign(keys[c], nulls[c]);
+    }
+
+    dynamic ret(type::MAP);
+    ret["size"]    = rows;
+    ret["columns"] = column_map;
+    ret["nulls"]   = null_map;
+    return ret;
+}
+
+dynamic dynamic::from_columns(const dynamic &table) {
+    const size_t   rows    = table.at("size").as_ulong();
+    const dynamic &columns = table.at("columns");
+    const dynamic *nulls   = table.lookup("nulls");
+
+    vector<dynamic>         keys;
+    vector<const dynamic *> sources;
+    vector<const dynamic *> bitmaps;
+    for (const auto item : columns) {
+        if (!item.value().is_array() || item.value().size() != rows)
+            throw range_error(fmt::format("dynamic column {} does not have {} rows",
+                                          item.key().as_string(), rows));
+        keys.push_back(item.key());
+        sources.push_back(&item.value());
+        bitmaps.push_back(nulls == nullptr ? nullptr : nulls->lookup(item.key()));
+    }
+
+    vector<vector<dynamic>> cells(keys.size());
+    vector<vector<long>>    missing(keys.size());
+    thread_pool::shared().run(keys.size(), column_workers(), [&](size_t c) {
+        cells[c].reserve(rows);
+        for (size_t i = 0; i < rows; i++)
+            cells[c].push_back(sources[c]->element(i));
+        if (bitmaps[c] != nullptr) {
+            missing[c].resize(bitmaps[c]->size());
+            for (size_t w = 0; w < missing[c].size(); w++)
+                missing[c][w] = bitmaps[c]->element(w).as_long();
+        }
+    });
+
+    dynamic ret(type::ARRAY);
+    ret.resize(rows);
+    dynamic *    items  = ret.data();
+    const size_t chunks = (rows + ROW_GRAIN - 1) / ROW_GRAIN;
+    thread_pool::shared().run(chunks, column_workers(), [&](size_t chunk) {
+        for (size_t i = chunk * ROW_GRAIN; i < std::min((chunk + 1) * ROW_GRAIN, rows); i++)
+            for (size_t c = 0; c < keys.size(); c++) {
+                const size_t word = i / 64;
+                if (word < missing[c].size() &&
+                    (static_cast<unsigned long>(missing[c][word]) >> (i % 64)) & 1UL)
+                    continue;
+                items[i].insert_or_assign(keys[c], cells[c][i]);
+            }
+    });
+    return ret;
+}
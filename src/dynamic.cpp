@@ -2,15 +2,395 @@
 
 #define FMT_HEADER_ONLY
 
+#include "stream.hpp"
+
 #include <fmt/format.h>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
 #include <cstring>
 #include <fstream>
+#include <functional>
+#include <mutex>
 #include <streambuf>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 using namespace std;
 
 namespace njones {
-    struct dynamic::container {
+    static atomic<uint64_t> version_source(1);
+
+    static mutex            unpack_lock;
+    static mutex            depend_lock;
+    static mutex            shape_lock;
+    static mutex            atom_lock;
+
+    static const size_t SHAPE_LINEAR_KEYS   = 8;
+    static const size_t SHAPE_MAX_KEYS      = 64;
+    static const size_t VALUE_BLOCK         = 8;
+    static const size_t ATOM_MAX_LENGTH     = 32;
+    static const size_t ATOM_MAX_COUNT      = 4096;
+    static const size_t ORDERED_MIN_COMPACT = 16;
+    static const uint64_t VERSION_BLOCK     = 4096;
+
+    // Versions are handed out to each thread in blocks, so no two containers ever share one and
+    // a version names both a container and the state it was in.
+    static uint64_t next_version() {
+        static thread_local uint64_t next  = 0;
+        static thread_local uint64_t limit = 0;
+        if (next == limit) {
+            next  = version_source.fetch_add(VERSION_BLOCK, memory_order_relaxed);
+            limit = next + VERSION_BLOCK;
+        }
+        return next++;
+    }
+
+    struct dynamic::container : enable_shared_from_this<dynamic::container> {
+        struct packed_array {
+            dynamic::type  t;
+            vector<long>   longs;
+            vector<double> doubles;
+
+            size_t size() const {
+                return t == dynamic::type::DOUBLE ? doubles.size() : longs.size();
+            }
+        };
+
+        struct map_shape : enable_shared_from_this<map_shape> {
+            shared_ptr<map_shape>                       parent;
+            vector<dynamic>                             keys;
+            unordered_map<dynamic, size_t>              slots;
+            unordered_map<dynamic, weak_ptr<map_shape>> transitions;
+
+            size_t find(const dynamic &key) const {
+                if (keys.size() <= SHAPE_LINEAR_KEYS) {
+                    for (size_t i = 0; i < keys.size(); i++)
+                        if (keys[i] == key)
+                            return i;
+                    return keys.size();
+                }
+                auto iter = slots.find(key);
+                return iter == slots.end() ? keys.size() : iter->second;
+            }
+
+            shared_ptr<map_shape> extend(const dynamic &key) {
+                lock_guard<mutex> l(shape_lock);
+                auto              iter = transitions.find(key);
+                if (iter != transitions.end()) {
+                    shared_ptr<map_shape> ret = iter->second.lock();
+                    if (ret)
+                        return ret;
+                }
+
+                shared_ptr<map_shape> ret = make_shared<map_shape>();
+                ret->parent               = shared_from_this();
+                ret->keys.reserve(keys.size() + 1);
+                ret->keys = keys;
+                ret->keys.push_back(key_of(key));
+                if (ret->keys.size() > SHAPE_LINEAR_KEYS)
+                    for (size_t i = 0; i < ret->keys.size(); i++)
+                        ret->slots[ret->keys[i]] = i;
+                transitions[ret->keys.back()] = ret;
+                return ret;
+            }
+
+            static shared_ptr<map_shape> root() {
+                static const shared_ptr<map_shape> ret = make_shared<map_shape>();
+                return ret;
+            }
+        };
+
+        // Map values are never moved once stored, so a reference returned by operator[] or at()
+        // stays valid while other keys are inserted. The first VALUE_BLOCK values share one
+        // allocation and later ones go into blocks that double in size, instead of reallocating.
+        struct value_store {
+            dynamic *         head = nullptr;
+            vector<dynamic *> tail;
+            size_t            count = 0;
+
+            value_store() = default;
+
+            value_store(const value_store &rhs) {
+                *this = rhs;
+            }
+
+            value_store(value_store &&rhs) : head(rhs.head), tail(move(rhs.tail)), count(rhs.count) {
+                rhs.head = nullptr;
+                rhs.tail.clear();
+                rhs.count = 0;
+            }
+
+            ~value_store() {
+                clear();
+            }
+
+            value_store &operator=(const value_store &rhs) {
+                if (this != &rhs) {
+                    clear();
+                    for (size_t i = 0; i < rhs.count; i++)
+                        push_back(rhs[i]);
+                }
+                return *this;
+            }
+
+            size_t size() const {
+                return count;
+            }
+
+            dynamic &operator[](const size_t i) {
+                return *slot(i);
+            }
+
+            const dynamic &operator[](const size_t i) const {
+                return *slot(i);
+            }
+
+            dynamic &push_back(const dynamic &val) {
+                dynamic *p;
+                if (count < VALUE_BLOCK) {
+                    if (head == nullptr)
+                        head = allocate(VALUE_BLOCK);
+                    p = head + count;
+                } else {
+                    size_t       i = count - VALUE_BLOCK;
+                    const size_t b = locate(i);
+                    if (b == tail.size()) {
+                        tail.reserve(b + 1);
+                        tail.push_back(allocate(VALUE_BLOCK << (b + 1)));
+                    }
+                    p = tail[b] + i;
+                }
+                new (p) dynamic(val);
+                count++;
+                return *p;
+            }
+
+            void clear() {
+                size_t left = count;
+                for (size_t i = 0; i < VALUE_BLOCK && left > 0; i++, left--)
+                    head[i].~dynamic();
+                for (size_t b = 0; b < tail.size(); b++)
+                    for (size_t i = 0; i < VALUE_BLOCK << (b + 1) && left > 0; i++, left--)
+                        tail[b][i].~dynamic();
+                ::operator delete(head);
+                for (dynamic *block : tail)
+                    ::operator delete(block);
+                head = nullptr;
+                tail.clear();
+                count = 0;
+            }
+
+            dynamic *slot(size_t i) const {
+                if (i < VALUE_BLOCK)
+                    return head + i;
+                i -= VALUE_BLOCK;
+                const size_t b = locate(i);
+                return tail[b] + i;
+            }
+
+            // Returns the tail block holding offset i past the head and leaves i as the offset
+            // within that block.
+            static size_t locate(size_t &i) {
+                size_t b = 0;
+                for (size_t n = VALUE_BLOCK << 1; i >= n; n <<= 1, b++)
+                    i -= n;
+                return b;
+            }
+
+            static dynamic *allocate(const size_t n) {
+                return static_cast<dynamic *>(::operator new(n * sizeof(dynamic)));
+            }
+        };
+
+        struct shaped_map {
+            shared_ptr<map_shape> shape;
+            value_store           values;
+        };
+
+        struct sharded_map {
+            vector<unordered_map<dynamic, dynamic>> maps;
+            unique_ptr<mutex[]>                     locks;
+
+            sharded_map(const size_t count) : maps(count), locks(new mutex[count]) {
+            }
+
+            sharded_map(const sharded_map &rhs)
+                : maps(rhs.maps.size()), locks(new mutex[rhs.maps.size()]) {
+                for (size_t i = 0; i < maps.size(); i++) {
+                    lock_guard<mutex> l(rhs.locks[i]);
+                    maps[i] = rhs.maps[i];
+                }
+            }
+
+            size_t index(const dynamic &key) const {
+                return key.hash() % maps.size();
+            }
+        };
+
+        // Entries point into values, so compacting or rehashing the index never moves a value.
+        // Slots of removed values are kept in spare and reused by later inserts.
+        struct ordered_map {
+            vector<pair<dynamic, dynamic *>> entries;
+            vector<size_t>                   hashes;
+            vector<uint32_t>                 slots;
+            value_store                      values;
+            vector<dynamic *>                spare;
+            size_t                           live       = 0;
+            bool                             keep_order = false;
+
+            explicit ordered_map(const bool keep_order = false) : keep_order(keep_order) {
+            }
+
+            ordered_map(const ordered_map &rhs) : keep_order(rhs.keep_order) {
+                entries.reserve(rhs.live);
+                for (const auto &e : rhs.entries)
+                    if (e.first.v)
+                        insert(e.first, *e.second);
+            }
+
+            explicit ordered_map(shaped_map &&m) : values(move(m.values)) {
+                live = values.size();
+                entries.reserve(live + 1);
+                hashes.reserve(live + 1);
+                for (size_t i = 0; i < live; i++) {
+                    entries.emplace_back(m.shape->keys[i], &values[i]);
+                    hashes.push_back(m.shape->keys[i].hash());
+                }
+                rehash();
+            }
+
+            ordered_map &operator=(const ordered_map &) = delete;
+
+            size_t locate(const dynamic &key, const size_t h) const {
+                const size_t mask = slots.size() - 1;
+                for (size_t i = h & mask;; i = (i + 1) & mask) {
+                    const uint32_t slot = slots[i];
+                    if (slot == 0)
+                        return i;
+                    const pair<dynamic, dynamic *> &e = entries[slot - 1];
+                    if (hashes[slot - 1] == h && e.first.v && e.first == key)
+                        return i;
+                }
+            }
+
+            dynamic *find(const dynamic &key) {
+                if (live == 0)
+                    return nullptr;
+                const uint32_t slot = slots[locate(key, key.hash())];
+                return slot == 0 ? nullptr : entries[slot - 1].second;
+            }
+
+            dynamic &insert(const dynamic &key, const dynamic &val) {
+                if ((entries.size() + 1) * 2 > slots.size())
+                    rehash();
+                const size_t h = key.hash();
+                const size_t i = locate(key, h);
+                if (slots[i] != 0)
+                    return *entries[slots[i] - 1].second = val;
+
+                dynamic *stored;
+                if (spare.empty())
+                    stored = &values.push_back(val);
+                else {
+                    stored = spare.back();
+                    spare.pop_back();
+                    *stored = val;
+                }
+                slots[i] = static_cast<uint32_t>(entries.size() + 1);
+                entries.emplace_back(key_of(key), stored);
+                hashes.push_back(h);
+                live++;
+                return *stored;
+            }
+
+            bool remove(const dynamic &key) {
+                if (live == 0)
+                    return false;
+                const size_t   i    = locate(key, key.hash());
+                const uint32_t slot = slots[i];
+                if (slot == 0)
+                    return false;
+
+                pair<dynamic, dynamic *> &e = entries[slot - 1];
+                e.first.v.reset();
+                e.second->v.reset();
+                spare.push_back(e.second);
+                e.second = nullptr;
+                live--;
+                if (!keep_order)
+                    close(i);
+                else if (entries.size() >= ORDERED_MIN_COMPACT && live * 2 < entries.size())
+                    rehash();
+                return true;
+            }
+
+            // Without an order to keep, an erase moves the last entry into the freed one and
+            // shifts later probes back over the freed slot, so no tombstone is left behind.
+            void close(size_t hole) {
+                const size_t mask = slots.size() - 1;
+                const size_t gone = slots[hole] - 1;
+                for (size_t j = (hole + 1) & mask; slots[j] != 0; j = (j + 1) & mask)
+                    if (((j - hashes[slots[j] - 1]) & mask) >= ((j - hole) & mask)) {
+                        slots[hole] = slots[j];
+                        hole        = j;
+                    }
+                slots[hole] = 0;
+
+                const size_t last = entries.size() - 1;
+                if (gone != last) {
+                    size_t j = hashes[last] & mask;
+                    while (slots[j] != last + 1)
+                        j = (j + 1) & mask;
+                    slots[j]      = static_cast<uint32_t>(gone + 1);
+                    entries[gone] = move(entries[last]);
+                    hashes[gone]  = hashes[last];
+                }
+                entries.pop_back();
+                hashes.pop_back();
+            }
+
+            void clear() {
+                entries.clear();
+                hashes.clear();
+                slots.clear();
+                values.clear();
+                spare.clear();
+                live = 0;
+            }
+
+            void rehash() {
+                if (live < entries.size()) {
+                    size_t n = 0;
+                    for (size_t i = 0; i < entries.size(); i++)
+                        if (entries[i].first.v) {
+                            if (n != i) {
+                                entries[n] = move(entries[i]);
+                                hashes[n]  = hashes[i];
+                            }
+                            n++;
+                        }
+                    entries.resize(n);
+                    hashes.resize(n);
+                }
+
+                size_t size = 8;
+                while (size < (entries.size() + 1) * 2)
+                    size <<= 1;
+                slots.assign(size, 0);
+                for (size_t e = 0; e < entries.size(); e++) {
+                    size_t i = hashes[e] & (size - 1);
+                    while (slots[i] != 0)
+                        i = (i + 1) & (size - 1);
+                    slots[i] = static_cast<uint32_t>(e + 1);
+                }
+            }
+        };
+
         union value {
             int                              intVal;
             unsigned int                     uintVal;
@@ -20,7 +400,9 @@ namespace njones {
             bool                             boolVal;
             string *                         stringVal;
             vector<dynamic> *                arrayVal;
-            unordered_map<dynamic, dynamic> *mapVal;
+            shaped_map *                     shapedVal;
+            sharded_map *                    shardedVal;
+            ordered_map *                    orderedVal;
         };
 
         container() {
@@ -34,11 +416,21 @@ namespace njones {
                 case dynamic::type::STRING:
                     *(v.stringVal) = *(rhs.v.stringVal);
                     break;
-                case dynamic::type::ARRAY:
-                    *(v.arrayVal) = *(rhs.v.arrayVal);
+                case dynamic::type::ARRAY: {
+                    const shared_ptr<const packed_array> p = rhs.packed_values();
+                    if (p)
+                        adopt(new packed_array(*p));
+                    else
+                        *(v.arrayVal) = *(rhs.v.arrayVal);
                     break;
+                }
                 case dynamic::type::MAP:
-                    *(v.mapVal) = *(rhs.v.mapVal);
+                    if (rhs.sharded)
+                        adopt(new sharded_map(*(rhs.v.shardedVal)));
+                    else if (rhs.ordered)
+                        adopt(new ordered_map(*(rhs.v.orderedVal)));
+                    else
+                        *(v.shapedVal) = *(rhs.v.shapedVal);
                     break;
                 default:
                     memcpy(&v, &rhs.v, sizeof(v));
@@ -53,10 +445,18 @@ namespace njones {
                     *(v.stringVal) = *(rhs.v.stringVal);
                     break;
                 case dynamic::type::ARRAY:
-                    *(v.arrayVal) = *(rhs.v.arrayVal);
+                    if (rhs.is_packed())
+                        adopt(new packed_array(*(rhs.packed)));
+                    else
+                        *(v.arrayVal) = *(rhs.v.arrayVal);
                     break;
                 case dynamic::type::MAP:
-                    *(v.mapVal) = *(rhs.v.mapVal);
+                    if (rhs.sharded)
+                        adopt(new sharded_map(*(rhs.v.shardedVal)));
+                    else if (rhs.ordered)
+                        adopt(new ordered_map(*(rhs.v.orderedVal)));
+                    else
+                        *(v.shapedVal) = *(rhs.v.shapedVal);
                     break;
                 default:
                     memcpy(&v, &rhs.v, sizeof(v));
@@ -70,6 +470,7 @@ namespace njones {
         }
 
         void set_type(const dynamic::type t) {
+            touch();
             reset_type();
             this->t = t;
             switch (t) {
@@ -80,7 +481,8 @@ namespace njones {
                     v.arrayVal = new vector<dynamic>{};
                     break;
                 case dynamic::type::MAP:
-                    v.mapVal = new unordered_map<dynamic, dynamic>{};
+                    v.shapedVal = new shaped_map{map_shape::root(), {}};
+                    shaped      = true;
                     break;
                 default:
                     break;
@@ -98,11 +500,20 @@ namespace njones {
                     if (v.arrayVal != nullptr)
                         delete v.arrayVal;
                     v.arrayVal = nullptr;
+                    packed.reset();
+                    packed_active.store(false, memory_order_release);
                     break;
                 case dynamic::type::MAP:
-                    if (v.mapVal != nullptr)
-                        delete v.mapVal;
-                    v.mapVal = nullptr;
+                    if (shaped)
+                        delete v.shapedVal;
+                    else if (sharded)
+                        delete v.shardedVal;
+                    else
+                        delete v.orderedVal;
+                    v.orderedVal = nullptr;
+                    shaped   = false;
+                    sharded  = false;
+                    ordered  = false;
                     break;
                 default:
                     break;
@@ -111,55 +522,447 @@ namespace njones {
             t = dynamic::type::NONE;
         }
 
-        value         v;
-        dynamic::type t;
+        void touch() {
+            if (atom)
+                throw domain_error("dynamic value is an interned key and cannot be modified");
+            version.store(next_version(), memory_order_release);
+            invalidate();
+        }
+
+        // Records that a cached hash or fragment of parent was built from this container.
+        void depend(const weak_ptr<container> &parent) {
+            lock_guard<mutex> l(depend_lock);
+            bool              found = false;
+            size_t            live  = 0;
+            for (size_t i = 0; i < dependents.size(); i++) {
+                if (dependents[i].expired())
+                    continue;
+                found = found || (!dependents[i].owner_before(parent) &&
+                                  !parent.owner_before(dependents[i]));
+                if (live != i)
+                    dependents[live] = move(dependents[i]);
+                live++;
+            }
+            dependents.resize(live);
+            if (!found)
+                dependents.push_back(parent);
+            observed.store(true, memory_order_release);
+        }
+
+        // Called when this container changes or leaves a slot. Bumps the version of every
+        // container whose caches were built from it, and of theirs in turn, so exactly the
+        // caches on the paths above it are rebuilt. Each container is registered again when
+        // its caches are, so repeated writes below a stale cache find nothing to walk.
+        void invalidate() {
+            if (!observed.load(memory_order_acquire))
+                return;
+            vector<shared_ptr<container>> done;
+            lock_guard<mutex>             l(depend_lock);
+            size_t                        next = done.size();
+            release(done);
+            while (next < done.size()) {
+                container &c = *done[next++];
+                c.version.store(next_version(), memory_order_release);
+                c.release(done);
+            }
+        }
+
+        void release(vector<shared_ptr<container>> &out) {
+            for (const weak_ptr<container> &w : dependents) {
+                shared_ptr<container> parent = w.lock();
+                if (parent)
+                    out.push_back(move(parent));
+            }
+            dependents.clear();
+            observed.store(false, memory_order_release);
+        }
+
+        bool is_packed() const {
+            return packed_active.load(memory_order_acquire);
+        }
+
+        // Readers that may run beside an unpack on another thread hold the values through this,
+        // so the unpack can release them as soon as the last such reader is done.
+        shared_ptr<const packed_array> packed_values() const {
+            return is_packed() ? atomic_load(&packed) : shared_ptr<const packed_array>();
+        }
+
+        // One element by value, read from the packed values without unpacking them.
+        dynamic element(const size_t index) const {
+            const shared_ptr<const packed_array> p = packed_values();
+            if (p && p->t == dynamic::type::DOUBLE)
+                return p->doubles[index];
+            if (p && p->t == dynamic::type::INT)
+                return static_cast<int>(p->longs[index]);
+            if (p)
+                return p->longs[index];
+            return (*(v.arrayVal))[index];
+        }
+
+        void adopt(packed_array *p) {
+            delete v.arrayVal;
+            v.arrayVal = nullptr;
+            packed.reset(p);
+            packed_active.store(true, memory_order_release);
+        }
+
+        void adopt(sharded_map *m) {
+            reset_type();
+            t            = dynamic::type::MAP;
+            v.shardedVal = m;
+            sharded      = true;
+        }
+
+        void adopt(ordered_map *m) {
+            reset_type();
+            t            = dynamic::type::MAP;
+            v.orderedVal = m;
+            ordered      = true;
+        }
+
+        void unpack() {
+            lock_guard<mutex> l(unpack_lock);
+            if (!is_packed())
+                return;
+
+            vector<dynamic> *items = new vector<dynamic>();
+            items->reserve(packed->size());
+            if (packed->t == dynamic::type::DOUBLE)
+                for (const double d : packed->doubles)
+                    items->emplace_back(d);
+            else if (packed->t == dynamic::type::INT)
+                for (const long l : packed->longs)
+                    items->emplace_back(static_cast<int>(l));
+            else
+                for (const long l : packed->longs)
+                    items->emplace_back(l);
+            v.arrayVal = items;
+            packed_active.store(false, memory_order_release);
+            atomic_store(&packed, shared_ptr<packed_array>());
+
+            // Caches built from the packed values must see writes through the new elements.
+            if (hashed_version.load(memory_order_acquire) != 0 || atomic_load(&memo)) {
+                const weak_ptr<container> self(shared_from_this());
+                for (const dynamic &d : *items)
+                    d.v->depend(self);
+            }
+        }
+
+        vector<dynamic> &elements() {
+            if (is_packed())
+                unpack();
+            return *(v.arrayVal);
+        }
+
+        void unshape() {
+            if (!shaped)
+                return;
+
+            shaped_map * m     = v.shapedVal;
+            ordered_map *items = new ordered_map(move(*m));
+            delete m;
+            v.orderedVal = items;
+            shaped       = false;
+            ordered      = true;
+        }
+
+        dynamic *find(const dynamic &key) {
+            if (sharded) {
+                sharded_map &     m = *(v.shardedVal);
+                const size_t      i = m.index(key);
+                lock_guard<mutex> l(m.locks[i]);
+                auto              iter = m.maps[i].find(key);
+                return iter == m.maps[i].end() ? nullptr : &(iter->second);
+            }
+            if (shaped) {
+                const size_t slot = v.shapedVal->shape->find(key);
+                return slot < v.shapedVal->values.size() ? &v.shapedVal->values[slot] : nullptr;
+            }
+            return v.orderedVal->find(key);
+        }
+
+        dynamic &insert(const dynamic &key, const dynamic &val) {
+            if (sharded) {
+                sharded_map &     m = *(v.shardedVal);
+                const size_t      i = m.index(key);
+                lock_guard<mutex> l(m.locks[i]);
+                auto              iter = m.maps[i].find(key);
+                if (iter != m.maps[i].end())
+                    return iter->second;
+                return m.maps[i].emplace(key_of(key), val).first->second;
+            }
+            if (shaped && v.shapedVal->values.size() < SHAPE_MAX_KEYS) {
+                v.shapedVal->shape = v.shapedVal->shape->extend(key);
+                return v.shapedVal->values.push_back(val);
+            }
+            unshape();
+            return v.orderedVal->insert(key, val);
+        }
+
+        bool get(const dynamic &key, dynamic &out) {
+            if (sharded) {
+                sharded_map &     m = *(v.shardedVal);
+                const size_t      i = m.index(key);
+                lock_guard<mutex> l(m.locks[i]);
+                auto              iter = m.maps[i].find(key);
+                if (iter == m.maps[i].end())
+                    return false;
+                out = iter->second;
+                return true;
+            }
+            dynamic *found = find(key);
+            if (found == nullptr)
+                return false;
+            out = *found;
+            return true;
+        }
+
+        void put(const dynamic &key, const dynamic &val) {
+            if (sharded) {
+                sharded_map &     m = *(v.shardedVal);
+                const size_t      i = m.index(key);
+                lock_guard<mutex> l(m.locks[i]);
+                auto              iter = m.maps[i].find(key);
+                if (iter != m.maps[i].end())
+                    iter->second = val;
+                else
+                    m.maps[i].emplace(key_of(key), val);
+                return;
+            }
+            dynamic *found = find(key);
+            if (found != nullptr)
+                *found = val;
+            else
+                insert(key, val);
+        }
+
+        dynamic compute(const dynamic &key, const function<dynamic()> &fn) {
+            if (sharded) {
+                sharded_map &     m = *(v.shardedVal);
+                const size_t      i = m.index(key);
+                lock_guard<mutex> l(m.locks[i]);
+                auto              iter = m.maps[i].find(key);
+                if (iter != m.maps[i].end())
+                    return iter->second;
+                return m.maps[i].emplace(key_of(key), fn()).first->second;
+            }
+            dynamic *found = find(key);
+            return found != nullptr ? *found : insert(key, fn());
+        }
+
+        bool remove(const dynamic &key) {
+            if (sharded) {
+                sharded_map &     m = *(v.shardedVal);
+                const size_t      i = m.index(key);
+                lock_guard<mutex> l(m.locks[i]);
+                return m.maps[i].erase(key) > 0;
+            }
+            if (find(key) == nullptr)
+                return false;
+            unshape();
+            return v.orderedVal->remove(key);
+        }
+
+        size_t count() const {
+            if (shaped)
+                return v.shapedVal->values.size();
+            if (!sharded)
+                return v.orderedVal->live;
+            size_t ret = 0;
+            for (size_t i = 0; i < v.shardedVal->maps.size(); i++) {
+                lock_guard<mutex> l(v.shardedVal->locks[i]);
+                ret += v.shardedVal->maps[i].size();
+            }
+            return ret;
+        }
+
+        static shared_ptr<container> intern(const string &key, const bool force) {
+            static unordered_map<string, shared_ptr<container>> *atoms =
+                new unordered_map<string, shared_ptr<container>>();
+
+            lock_guard<mutex> l(atom_lock);
+            auto              iter = atoms->find(key);
+            if (iter != atoms->end())
+                return iter->second;
+            if (!force && (key.size() > ATOM_MAX_LENGTH || atoms->size() >= ATOM_MAX_COUNT))
+                return nullptr;
+
+            dynamic ret(key);
+            ret.hash();
+            ret.v->atom = true;
+            atoms->emplace(key, ret.v);
+            return ret.v;
+        }
+
+        static dynamic key_of(const dynamic &key) {
+            if (key.v->atom)
+                return key;
+            if (key.v->t != dynamic::type::STRING)
+                return key.deep_copy();
+            shared_ptr<container> a = intern(*(key.v->v.stringVal), false);
+            if (!a)
+                return key.deep_copy();
+            dynamic ret(key);
+            ret.v = a;
+            return ret;
+        }
+
+        template <class F>
+        void entries(F fn) const {
+            if (shaped)
+                for (size_t i = 0; i < v.shapedVal->values.size(); i++)
+                    fn(v.shapedVal->shape->keys[i], v.shapedVal->values[i]);
+            else if (sharded)
+                for (size_t i = 0; i < v.shardedVal->maps.size(); i++) {
+                    vector<pair<dynamic, dynamic>> items;
+                    {
+                        lock_guard<mutex> l(v.shardedVal->locks[i]);
+                        items.assign(v.shardedVal->maps[i].begin(), v.shardedVal->maps[i].end());
+                    }
+                    for (const auto &p : items)
+                        fn(p.first, p.second);
+                }
+            else
+                for (const auto &p : v.orderedVal->entries)
+                    if (p.first.v)
+                        fn(p.first, *p.second);
+        }
+
+        template <class F>
+        void children(const size_t indent, F fn) const {
+            if (t == dynamic::type::MAP)
+                entries([indent, &fn](const dynamic &key, const dynamic &val) {
+                    fn(key, indent);
+                    fn(val, indent + 1);
+                });
+            else if (t == dynamic::type::ARRAY && !is_packed())
+                for (const dynamic &d : *(v.arrayVal))
+                    fn(d, indent);
+        }
+
+        // The text a container renders itself, with the fragments of nested containers held by
+        // reference and spliced in at their offsets, so each byte is stored once per document.
+        // Entries returned from str() also keep the joined text, built on first use.
+        struct memo_entry {
+            string                                             bytes;
+            vector<pair<size_t, shared_ptr<const memo_entry>>> nested;
+            uint64_t                                           version;
+            size_t                                             size;
+            size_t                                             indent;
+            bool                                               pretty;
+            mutable shared_ptr<const string>                   flat;
+
+            template <class Put>
+            void write(Put put) const {
+                size_t at = 0;
+                for (const auto &n : nested) {
+                    put(bytes.data() + at, n.first - at);
+                    n.second->write(put);
+                    at = n.first;
+                }
+                put(bytes.data() + at, bytes.size() - at);
+            }
+
+            shared_ptr<const string> text() const {
+                shared_ptr<const string> ret = atomic_load(&flat);
+                if (!ret) {
+                    string *joined = new string();
+                    joined->reserve(size);
+                    write([joined](const char *data, const size_t n) { joined->append(data, n); });
+                    ret.reset(joined);
+                    atomic_store(&flat, ret);
+                }
+                return ret;
+            }
+        };
+
+        template <class Put, class Child>
+        void render(const bool pretty, const size_t indent, Put put, Child child) const;
+
+        shared_ptr<const memo_entry> fragment(const bool pretty, const size_t indent);
+
+        void forget() {
+            atomic_store(&memo, shared_ptr<const memo_entry>());
+            children(0, [](const dynamic &d, const size_t) { d.v->forget(); });
+        }
+
+        value                        v;
+        dynamic::type                t;
+        bool                         shaped   = false;
+        bool                         sharded  = false;
+        bool                         ordered  = false;
+        bool                         atom     = false;
+        bool                         memoized = false;
+        atomic<bool>                 packed_active{false};
+        shared_ptr<packed_array>     packed;
+        atomic<bool>                 observed{false};
+        vector<weak_ptr<container>>  dependents;
+        atomic<uint64_t>             version{next_version()};
+        atomic<uint64_t>             hashed_version{0};
+        atomic<size_t>               hash_value{0};
+        shared_ptr<const memo_entry> memo;
     };
 }  // namespace njones
 
 using namespace njones;
 
-static string escape_string(const string &str) {
+template <class F>
+static void escape(const string &str, F put) {
     static const char *const HEX_DIGITS = "0123456789ABCDEF";
 
-    ostringstream s;
-    s << '"';
-    for (const char c : str) {
+    put("\"", 1);
+    size_t run = 0;
+    for (size_t i = 0; i < str.size(); i++) {
+        const char c = str[i];
         if (' ' <= c && c <= '~' && c != '\\' && c != '"')
-            s << c;
-        else {
-            s << '\\';
-            switch (c) {
-                case '"':
-                    s << '"';
-                    break;
-                case '\\':
-                    s << '\\';
-                    break;
-                case '\t':
-                    s << 't';
-                    break;
-                case '\r':
-                    s << 'r';
-                    break;
-                case '\n':
-                    s << 'n';
-                    break;
-                default:
-                    s << 'x';
-                    s << HEX_DIGITS[c >> 4];
-                    s << HEX_DIGITS[c & 0xF];
-            }
+            continue;
+
+        char   e[4] = {'\\', 'x', HEX_DIGITS[(c >> 4) & 0xF], HEX_DIGITS[c & 0xF]};
+        size_t n    = 2;
+        switch (c) {
+            case '"':
+                e[1] = '"';
+                break;
+            case '\\':
+                e[1] = '\\';
+                break;
+            case '\t':
+                e[1] = 't';
+                break;
+            case '\r':
+                e[1] = 'r';
+                break;
+            case '\n':
+                e[1] = 'n';
+                break;
+            default:
+                n = 4;
         }
+        put(str.data() + run, i - run);
+        put(e, n);
+        run = i + 1;
     }
-    s << '"';
-    return s.str();
+    put(str.data() + run, str.size() - run);
+    put("\"", 1);
+}
+
+static string escape_string(const string &str) {
+    string ret;
+    ret.reserve(str.size() + 2);
+    escape(str, [&ret](const char *data, const size_t size) { ret.append(data, size); });
+    return ret;
+}
+
+static const dynamic &array_key() {
+    static const dynamic key = dynamic::intern("");
+    return key;
 }
 
-dynamic_iterator_value::dynamic_iterator_value(const dynamic &key, dynamic *v) : _key(key), v(v) {
+dynamic_iterator_value::dynamic_iterator_value(const dynamic &key, dynamic *v) : _key(&key), v(v) {
 }
 
-dynamic dynamic_iterator_value::key() const {
-    return _key;
+const dynamic &dynamic_iterator_value::key() const {
+    return *_key;
 }
 
 dynamic &dynamic_iterator_value::value() const {
@@ -167,11 +970,16 @@ dynamic &dynamic_iterator_value::value() const {
 }
 
 const_dynamic_iterator_value::const_dynamic_iterator_value(const dynamic &key, const dynamic *v)
-    : _key(key), v(v) {
+    : _key(&key), v(v) {
 }
 
-dynamic const_dynamic_iterator_value::key() const {
-    return _key;
+const_dynamic_iterator_value::const_dynamic_iterator_value(const dynamic &                key,
+                                                           const shared_ptr<const dynamic> &item)
+    : _key(&key), v(item.get()), item(item) {
+}
+
+const dynamic &const_dynamic_iterator_value::key() const {
+    return *_key;
 }
 
 const dynamic &const_dynamic_iterator_value::value() const {
@@ -179,15 +987,64 @@ const dynamic &const_dynamic_iterator_value::value() const {
 }
 
 dynamic_iterator::dynamic_iterator(std::vector<dynamic>::iterator arrayIter)
-    : t(dynamic::type::ARRAY), arrayIter(arrayIter) {
-}
-
-dynamic_iterator::dynamic_iterator(std::unordered_map<dynamic, dynamic>::iterator mapIter)
-    : t(dynamic::type::MAP), mapIter(mapIter) {
+    : t(dynamic::type::ARRAY),
+      arrayIter(arrayIter),
+      keyIter(nullptr),
+      owner(nullptr),
+      shards(nullptr),
+      shard(0),
+      entryIter(nullptr),
+      entryEnd(nullptr) {
+}
+
+dynamic_iterator::dynamic_iterator(const dynamic *keyIter, dynamic::container *owner)
+    : t(dynamic::type::MAP),
+      keyIter(keyIter),
+      owner(owner),
+      shards(nullptr),
+      shard(0),
+      entryIter(nullptr),
+      entryEnd(nullptr) {
+}
+
+dynamic_iterator::dynamic_iterator(std::pair<dynamic, dynamic *> *entryIter,
+                                   std::pair<dynamic, dynamic *> *entryEnd)
+    : t(dynamic::type::MAP),
+      keyIter(nullptr),
+      owner(nullptr),
+      shards(nullptr),
+      shard(0),
+      entryIter(entryIter),
+      entryEnd(entryEnd) {
+    while (this->entryIter != entryEnd && !this->entryIter->first.v)
+        this->entryIter++;
+}
+
+dynamic_iterator::dynamic_iterator(std::vector<std::unordered_map<dynamic, dynamic>> *shards,
+                                   const size_t                                       shard,
+                                   std::unordered_map<dynamic, dynamic>::iterator     mapIter)
+    : t(dynamic::type::MAP),
+      mapIter(mapIter),
+      keyIter(nullptr),
+      owner(nullptr),
+      shards(shards),
+      shard(shard),
+      entryIter(nullptr),
+      entryEnd(nullptr) {
+    while (this->mapIter == (*shards)[this->shard].end() && this->shard + 1 < shards->size())
+        this->mapIter = (*shards)[++this->shard].begin();
 }
 
 dynamic_iterator::dynamic_iterator(const dynamic_iterator &other)
-    : t(other.t), arrayIter(other.arrayIter), mapIter(other.mapIter) {
+    : t(other.t),
+      arrayIter(other.arrayIter),
+      mapIter(other.mapIter),
+      keyIter(other.keyIter),
+      owner(other.owner),
+      shards(other.shards),
+      shard(other.shard),
+      entryIter(other.entryIter),
+      entryEnd(other.entryEnd) {
 }
 
 dynamic_iterator::~dynamic_iterator() {
@@ -196,8 +1053,17 @@ dynamic_iterator::~dynamic_iterator() {
 dynamic_iterator &dynamic_iterator::operator++() {
     if (t == dynamic::type::ARRAY)
         arrayIter++;
-    else
+    else if (shards != nullptr) {
         mapIter++;
+        while (mapIter == (*shards)[shard].end() && shard + 1 < shards->size())
+            mapIter = (*shards)[++shard].begin();
+    } else if (keyIter != nullptr)
+        keyIter++;
+    else {
+        entryIter++;
+        while (entryIter != entryEnd && !entryIter->first.v)
+            entryIter++;
+    }
     return *this;
 }
 
@@ -210,8 +1076,14 @@ dynamic_iterator dynamic_iterator::operator++(int) {
 dynamic_iterator &dynamic_iterator::operator--() {
     if (t == dynamic::type::ARRAY)
         arrayIter--;
+    else if (shards != nullptr)
+        throw domain_error("dynamic value concurrent map iterator cannot be decremented");
+    else if (keyIter != nullptr)
+        keyIter--;
     else
-        throw domain_error("dynamic value map iterator decrement not implemented");
+        do
+            entryIter--;
+        while (!entryIter->first.v);
     return *this;
 }
 
@@ -223,16 +1095,24 @@ dynamic_iterator dynamic_iterator::operator--(int) {
 
 dynamic::iterator::value dynamic_iterator::operator*() {
     if (t == dynamic::type::ARRAY)
-        return dynamic_iterator_value("", &(*arrayIter));
+        return dynamic_iterator_value(array_key(), &(*arrayIter));
+    else if (shards != nullptr)
+        return dynamic_iterator_value(mapIter->first, &(mapIter->second));
+    else if (keyIter != nullptr)
+        return dynamic_iterator_value(
+            *keyIter,
+            &owner->v.shapedVal->values[keyIter - owner->v.shapedVal->shape->keys.data()]);
     else
-        return dynamic_iterator_value((*mapIter).first, &(mapIter->second));
+        return dynamic_iterator_value(entryIter->first, entryIter->second);
 }
 
 bool dynamic_iterator::operator==(const dynamic_iterator &rhs) {
     if (t == dynamic::type::ARRAY)
         return arrayIter == rhs.arrayIter;
+    else if (shards != nullptr)
+        return shard == rhs.shard && mapIter == rhs.mapIter;
     else
-        return mapIter == rhs.mapIter;
+        return keyIter == rhs.keyIter && entryIter == rhs.entryIter;
 }
 
 bool dynamic_iterator::operator!=(const dynamic_iterator &rhs) {
@@ -240,23 +1120,22 @@ bool dynamic_iterator::operator!=(const dynamic_iterator &rhs) {
 }
 
 reverse_dynamic_iterator::reverse_dynamic_iterator(std::vector<dynamic>::reverse_iterator arrayIter)
-    : arrayIter(arrayIter) {
-    t = dynamic::type::ARRAY;
+    : current(arrayIter.base()) {
+}
+
+reverse_dynamic_iterator::reverse_dynamic_iterator(const dynamic_iterator &current)
+    : current(current) {
 }
 
 reverse_dynamic_iterator::reverse_dynamic_iterator(const reverse_dynamic_iterator &other)
-    : arrayIter(other.arrayIter) {
-    t = other.t;
+    : current(other.current) {
 }
 
 reverse_dynamic_iterator::~reverse_dynamic_iterator() {
 }
 
 reverse_dynamic_iterator &reverse_dynamic_iterator::operator++() {
-    if (t == dynamic::type::ARRAY)
-        arrayIter++;
-    else
-        throw domain_error("dynamic value map reverse_iterator not implemented");
+    --current;
     return *this;
 }
 
@@ -267,10 +1146,7 @@ reverse_dynamic_iterator reverse_dynamic_iterator::operator++(int) {
 }
 
 reverse_dynamic_iterator &reverse_dynamic_iterator::operator--() {
-    if (t == dynamic::type::ARRAY)
-        arrayIter--;
-    else
-        throw domain_error("dynamic value map reverse_iterator not implemented");
+    ++current;
     return *this;
 }
 
@@ -281,17 +1157,12 @@ reverse_dynamic_iterator reverse_dynamic_iterator::operator--(int) {
 }
 
 dynamic::reverse_iterator::value reverse_dynamic_iterator::operator*() {
-    if (t == dynamic::type::ARRAY)
-        return dynamic::reverse_iterator::value("", &(*arrayIter));
-    else
-        throw domain_error("dynamic value map reverse_iterator not implemented");
+    dynamic_iterator tmp(current);
+    return *(--tmp);
 }
 
 bool reverse_dynamic_iterator::operator==(const reverse_dynamic_iterator &rhs) {
-    if (t == dynamic::type::ARRAY)
-        return arrayIter == rhs.arrayIter;
-    else
-        throw domain_error("dynamic value map reverse_iterator not implemented");
+    return current == rhs.current;
 }
 
 bool reverse_dynamic_iterator::operator!=(const reverse_dynamic_iterator &rhs) {
@@ -299,26 +1170,102 @@ bool reverse_dynamic_iterator::operator!=(const reverse_dynamic_iterator &rhs) {
 }
 
 const_dynamic_iterator::const_dynamic_iterator(std::vector<dynamic>::const_iterator arrayIter)
-    : t(dynamic::type::ARRAY), arrayIter(arrayIter) {
+    : t(dynamic::type::ARRAY),
+      arrayIter(arrayIter),
+      keyIter(nullptr),
+      owner(nullptr),
+      shards(nullptr),
+      shard(0),
+      entryIter(nullptr),
+      entryEnd(nullptr),
+      index(0) {
+}
+
+const_dynamic_iterator::const_dynamic_iterator(const dynamic::container *owner, const size_t index)
+    : t(dynamic::type::ARRAY),
+      keyIter(nullptr),
+      owner(owner),
+      shards(nullptr),
+      shard(0),
+      entryIter(nullptr),
+      entryEnd(nullptr),
+      index(index) {
+}
+
+const_dynamic_iterator::const_dynamic_iterator(const dynamic *                 keyIter,
+                                               const dynamic::container *owner)
+    : t(dynamic::type::MAP),
+      keyIter(keyIter),
+      owner(owner),
+      shards(nullptr),
+      shard(0),
+      entryIter(nullptr),
+      entryEnd(nullptr),
+      index(0) {
+}
+
+const_dynamic_iterator::const_dynamic_iterator(const std::pair<dynamic, dynamic *> *entryIter,
+                                               const std::pair<dynamic, dynamic *> *entryEnd)
+    : t(dynamic::type::MAP),
+      keyIter(nullptr),
+      owner(nullptr),
+      shards(nullptr),
+      shard(0),
+      entryIter(entryIter),
+      entryEnd(entryEnd),
+      index(0) {
+    while (this->entryIter != entryEnd && !this->entryIter->first.v)
+        this->entryIter++;
 }
 
 const_dynamic_iterator::const_dynamic_iterator(
+    const std::vector<std::unordered_map<dynamic, dynamic>> *shards, const size_t shard,
     std::unordered_map<dynamic, dynamic>::const_iterator mapIter)
-    : t(dynamic::type::MAP), mapIter(mapIter) {
+    : t(dynamic::type::MAP),
+      mapIter(mapIter),
+      keyIter(nullptr),
+      owner(nullptr),
+      shards(shards),
+      shard(shard),
+      entryIter(nullptr),
+      entryEnd(nullptr),
+      index(0) {
+    while (this->mapIter == (*shards)[this->shard].cend() && this->shard + 1 < shards->size())
+        this->mapIter = (*shards)[++this->shard].cbegin();
 }
 
 const_dynamic_iterator::const_dynamic_iterator(const const_dynamic_iterator &other)
-    : t(other.t), arrayIter(other.arrayIter), mapIter(other.mapIter) {
+    : t(other.t),
+      arrayIter(other.arrayIter),
+      mapIter(other.mapIter),
+      keyIter(other.keyIter),
+      owner(other.owner),
+      shards(other.shards),
+      shard(other.shard),
+      entryIter(other.entryIter),
+      entryEnd(other.entryEnd),
+      index(other.index) {
 }
 
 const_dynamic_iterator::~const_dynamic_iterator() {
 }
 
 const_dynamic_iterator &const_dynamic_iterator::operator++() {
-    if (t == dynamic::type::ARRAY)
+    if (t == dynamic::type::ARRAY && owner != nullptr)
+        index++;
+    else if (t == dynamic::type::ARRAY)
         arrayIter++;
-    else
+    else if (shards != nullptr) {
         mapIter++;
+        while (mapIter == (*shards)[shard].end() && shard + 1 < shards->size())
+            mapIter = (*shards)[++shard].begin();
+    } else if (keyIter != nullptr)
+        keyIter++;
+    else {
+        entryIter++;
+        while (entryIter != entryEnd && !entryIter->first.v)
+            entryIter++;
+    }
     return *this;
 }
 
@@ -329,10 +1276,18 @@ const_dynamic_iterator const_dynamic_iterator::operator++(int) {
 }
 
 const_dynamic_iterator &const_dynamic_iterator::operator--() {
-    if (t == dynamic::type::ARRAY)
+    if (t == dynamic::type::ARRAY && owner != nullptr)
+        index--;
+    else if (t == dynamic::type::ARRAY)
         arrayIter--;
+    else if (shards != nullptr)
+        throw domain_error("dynamic value concurrent map iterator cannot be decremented");
+    else if (keyIter != nullptr)
+        keyIter--;
     else
-        throw range_error("dynamic value map iterator decrement not implemented");
+        do
+            entryIter--;
+        while (!entryIter->first.v);
     return *this;
 }
 
@@ -343,17 +1298,32 @@ const_dynamic_iterator const_dynamic_iterator::operator--(int) {
 }
 
 dynamic::const_iterator::value const_dynamic_iterator::operator*() {
-    if (t == dynamic::type::ARRAY)
-        return const_dynamic_iterator_value("", &(*arrayIter));
+    if (t == dynamic::type::ARRAY && owner != nullptr && owner->is_packed())
+        return const_dynamic_iterator_value(array_key(),
+                                            make_shared<const dynamic>(owner->element(index)));
+    else if (t == dynamic::type::ARRAY && owner != nullptr)
+        return const_dynamic_iterator_value(array_key(), &(*(owner->v.arrayVal))[index]);
+    else if (t == dynamic::type::ARRAY)
+        return const_dynamic_iterator_value(array_key(), &(*arrayIter));
+    else if (shards != nullptr)
+        return const_dynamic_iterator_value(mapIter->first, &(mapIter->second));
+    else if (keyIter != nullptr)
+        return const_dynamic_iterator_value(
+            *keyIter,
+            &owner->v.shapedVal->values[keyIter - owner->v.shapedVal->shape->keys.data()]);
     else
-        return const_dynamic_iterator_value((*mapIter).first, &(mapIter->second));
+        return const_dynamic_iterator_value(entryIter->first, entryIter->second);
 }
 
 bool const_dynamic_iterator::operator==(const const_dynamic_iterator &rhs) {
-    if (t == dynamic::type::ARRAY)
+    if (t == dynamic::type::ARRAY && owner != nullptr)
+        return index == rhs.index;
+    else if (t == dynamic::type::ARRAY)
         return arrayIter == rhs.arrayIter;
+    else if (shards != nullptr)
+        return shard == rhs.shard && mapIter == rhs.mapIter;
     else
-        return mapIter == rhs.mapIter;
+        return keyIter == rhs.keyIter && entryIter == rhs.entryIter;
 }
 
 bool const_dynamic_iterator::operator!=(const const_dynamic_iterator &rhs) {
@@ -362,24 +1332,24 @@ bool const_dynamic_iterator::operator!=(const const_dynamic_iterator &rhs) {
 
 const_reverse_dynamic_iterator::const_reverse_dynamic_iterator(
     std::vector<dynamic>::const_reverse_iterator arrayIter)
-    : arrayIter(arrayIter) {
-    t = dynamic::type::ARRAY;
+    : current(arrayIter.base()) {
+}
+
+const_reverse_dynamic_iterator::const_reverse_dynamic_iterator(
+    const const_dynamic_iterator &current)
+    : current(current) {
 }
 
 const_reverse_dynamic_iterator::const_reverse_dynamic_iterator(
     const const_reverse_dynamic_iterator &other)
-    : arrayIter(other.arrayIter) {
-    t = other.t;
+    : current(other.current) {
 }
 
 const_reverse_dynamic_iterator::~const_reverse_dynamic_iterator() {
 }
 
 const_reverse_dynamic_iterator &const_reverse_dynamic_iterator::operator++() {
-    if (t == dynamic::type::ARRAY)
-        arrayIter++;
-    else
-        throw domain_error("dynamic value map const_reverse_iterator not implemented");
+    --current;
     return *this;
 }
 
@@ -390,10 +1360,7 @@ const_reverse_dynamic_iterator const_reverse_dynamic_iterator::operator++(int) {
 }
 
 const_reverse_dynamic_iterator &const_reverse_dynamic_iterator::operator--() {
-    if (t == dynamic::type::ARRAY)
-        arrayIter--;
-    else
-        throw domain_error("dynamic value map const_reverse_iterator not implemented");
+    ++current;
     return *this;
 }
 
@@ -404,23 +1371,84 @@ const_reverse_dynamic_iterator const_reverse_dynamic_iterator::operator--(int) {
 }
 
 dynamic::const_reverse_iterator::value const_reverse_dynamic_iterator::operator*() {
-    if (t == dynamic::type::ARRAY)
-        return dynamic::const_reverse_iterator::value("", &(*arrayIter));
-    else
-        throw domain_error("dynamic value map const_reverse_iterator not implemented");
+    const_dynamic_iterator tmp(current);
+    return *(--tmp);
 }
 
 bool const_reverse_dynamic_iterator::operator==(const const_reverse_dynamic_iterator &rhs) {
-    if (t == dynamic::type::ARRAY)
-        return arrayIter == rhs.arrayIter;
-    else
-        throw domain_error("dynamic value map const_reverse_iterator not implemented");
+    return current == rhs.current;
 }
 
 bool const_reverse_dynamic_iterator::operator!=(const const_reverse_dynamic_iterator &rhs) {
     return !(*this == rhs);
 }
 
+static double sum_doubles(const double *values, const size_t count) {
+    size_t i   = 0;
+    double ret = 0;
+#if defined(__SSE2__)
+    __m128d a = _mm_setzero_pd();
+    __m128d b = _mm_setzero_pd();
+    for (; i + 4 <= count; i += 4) {
+        a = _mm_add_pd(a, _mm_loadu_pd(values + i));
+        b = _mm_add_pd(b, _mm_loadu_pd(values + i + 2));
+    }
+    double lanes[2];
+    _mm_storeu_pd(lanes, _mm_add_pd(a, b));
+    ret = lanes[0] + lanes[1];
+#endif
+    for (; i < count; i++)
+        ret += values[i];
+    return ret;
+}
+
+static double extreme_doubles(const double *values, const size_t count, const bool greatest) {
+    size_t i   = 0;
+    double ret = values[0];
+#if defined(__SSE2__)
+    // The lanes start from the first value and take each new element as the first operand, so a
+    // NaN is skipped unless it comes first, exactly like the scalar loop below.
+    if (count >= 4 && ret == ret) {
+        __m128d a = _mm_set1_pd(ret);
+        __m128d b = a;
+        for (; i + 4 <= count; i += 4) {
+            const __m128d x = _mm_loadu_pd(values + i);
+            const __m128d y = _mm_loadu_pd(values + i + 2);
+            a               = greatest ? _mm_max_pd(x, a) : _mm_min_pd(x, a);
+            b               = greatest ? _mm_max_pd(y, b) : _mm_min_pd(y, b);
+        }
+        double lanes[2];
+        _mm_storeu_pd(lanes, greatest ? _mm_max_pd(a, b) : _mm_min_pd(a, b));
+        ret = greatest ? std::max(lanes[0], lanes[1]) : std::min(lanes[0], lanes[1]);
+    }
+#endif
+    for (; i < count; i++)
+        ret = greatest ? std::max(ret, values[i]) : std::min(ret, values[i]);
+    return ret;
+}
+
+static double sum_longs(const long *values, const size_t count) {
+#if defined(__SIZEOF_INT128__)
+    __int128 ret = 0;
+#else
+    unsigned long ret = 0;
+#endif
+    for (size_t i = 0; i < count; i++)
+        ret += values[i];
+#if defined(__SIZEOF_INT128__)
+    return static_cast<double>(ret);
+#else
+    return static_cast<double>(static_cast<long>(ret));
+#endif
+}
+
+static double extreme_longs(const long *values, const size_t count, const bool greatest) {
+    long ret = values[0];
+    for (size_t i = 1; i < count; i++)
+        ret = greatest ? std::max(ret, values[i]) : std::min(ret, values[i]);
+    return ret;
+}
+
 const unordered_map<dynamic::type, string> njones::dynamic::TYPE_NAME = {
     {dynamic::type::NONE, "null"},   {dynamic::type::INT, "int"},
     {dynamic::type::UINT, "uint"},   {dynamic::type::LONG, "long"},
@@ -437,36 +1465,45 @@ dynamic::dynamic(const dynamic::type t) : v(make_shared<container>()) {
     set_type(t);
 }
 
-dynamic::dynamic(const dynamic &rhs) {
-    *this = rhs;
+dynamic::dynamic(const dynamic &rhs) : v(rhs.v) {
 }
 
-dynamic::dynamic(dynamic &&rhs) {
-    *this = rhs;
+// A moved-from value is left holding null rather than an empty handle, so it can still be read
+// and assigned to.
+dynamic::dynamic(dynamic &&rhs) : v(move(rhs.v)) {
+    rhs.v = make_shared<container>();
 }
 
 dynamic::~dynamic() {
 }
 
 dynamic &dynamic::operator=(const dynamic &rhs) {
+    if (v)
+        v->invalidate();
     v = rhs.v;
 
     return *this;
 }
 
 dynamic &dynamic::operator=(dynamic &&rhs) {
-    v = move(rhs.v);
+    if (v)
+        v->invalidate();
+    if (rhs.v)
+        rhs.v->invalidate();
+    v.swap(rhs.v);
 
     return *this;
 }
 
 dynamic &dynamic::operator=(const nullptr_t val) {
+    detach();
     v->set_type(dynamic::type::NONE);
 
     return *this;
 }
 
 dynamic &dynamic::operator=(const int val) {
+    detach();
     v->set_type(dynamic::type::INT);
     v->v.intVal = val;
 
@@ -474,6 +1511,7 @@ dynamic &dynamic::operator=(const int val) {
 }
 
 dynamic &dynamic::operator=(const unsigned int val) {
+    detach();
     v->set_type(dynamic::type::UINT);
     v->v.uintVal = val;
 
@@ -481,6 +1519,7 @@ dynamic &dynamic::operator=(const unsigned int val) {
 }
 
 dynamic &dynamic::operator=(const long val) {
+    detach();
     v->set_type(dynamic::type::LONG);
     v->v.longVal = val;
 
@@ -488,6 +1527,7 @@ dynamic &dynamic::operator=(const long val) {
 }
 
 dynamic &dynamic::operator=(const unsigned long val) {
+    detach();
     v->set_type(dynamic::type::ULONG);
     v->v.ulongVal = val;
 
@@ -495,6 +1535,7 @@ dynamic &dynamic::operator=(const unsigned long val) {
 }
 
 dynamic &dynamic::operator=(const double val) {
+    detach();
     v->set_type(dynamic::type::DOUBLE);
     v->v.doubleVal = val;
 
@@ -502,6 +1543,7 @@ dynamic &dynamic::operator=(const double val) {
 }
 
 dynamic &dynamic::operator=(const bool val) {
+    detach();
     v->set_type(dynamic::type::BOOL);
     v->v.boolVal = val;
 
@@ -509,6 +1551,7 @@ dynamic &dynamic::operator=(const bool val) {
 }
 
 dynamic &dynamic::operator=(const string &val) {
+    detach();
     v->set_type(dynamic::type::STRING);
     *(v->v.stringVal) = val;
 
@@ -516,6 +1559,7 @@ dynamic &dynamic::operator=(const string &val) {
 }
 
 dynamic &dynamic::operator=(const char *val) {
+    detach();
     v->set_type(dynamic::type::STRING);
     *(v->v.stringVal) = string(val);
 
@@ -551,11 +1595,39 @@ dynamic::operator string() {
 }
 
 bool dynamic::operator==(const dynamic &rhs) const {
+    if (v == rhs.v)
+        return true;
+    if (v->atom && rhs.v->atom)
+        return false;
+    if (v->t == type::STRING || rhs.v->t == type::STRING)
+        return v->t == rhs.v->t && *(v->v.stringVal) == *(rhs.v->v.stringVal);
+    if (hash() != rhs.hash())
+        return false;
+
+    if (v->t == type::MAP || rhs.v->t == type::MAP) {
+        if (v->t != rhs.v->t || size() != rhs.size())
+            return false;
+        bool ret = true;
+        v->entries([&rhs, &ret](const dynamic &key, const dynamic &val) {
+            const dynamic *other = ret ? rhs.lookup(key) : nullptr;
+            ret                  = other != nullptr && *other == val;
+        });
+        return ret;
+    }
+    if (v->t == type::ARRAY && rhs.v->t == type::ARRAY && !v->is_packed() &&
+        !rhs.v->is_packed()) {
+        if (size() != rhs.size())
+            return false;
+        for (size_t i = 0; i < size(); i++)
+            if ((*v->v.arrayVal)[i] != (*rhs.v->v.arrayVal)[i])
+                return false;
+        return true;
+    }
     return str() == rhs.str();
 }
 
 bool dynamic::operator!=(const dynamic &rhs) const {
-    return str() != rhs.str();
+    return !(*this == rhs);
 }
 
 bool dynamic::operator<(const dynamic &rhs) const {
@@ -579,6 +1651,7 @@ dynamic::type dynamic::get_type() const {
 }
 
 void dynamic::set_type(const dynamic::type t) {
+    detach();
     v->set_type(t);
 }
 
@@ -807,28 +1880,31 @@ string dynamic::as_string(const bool pretty) const {
 
 const dynamic &dynamic::operator[](const dynamic &key) const {
     if (v->t == type::MAP) {
-        if (!has(key))
+        const dynamic *val = v->find(key);
+        if (val == nullptr)
             throw range_error(fmt::format("dynamic value has no member: {}", key.str()));
-        return (*(v->v.mapVal)).at(key);
+        return *val;
     } else if (v->t == type::ARRAY) {
         if (key.as_ulong() >= size())
             throw range_error(fmt::format("dynamic value index out of range {} > {}",
                                           key.as_ulong(), size() - 1));
-        return (*(v->v.arrayVal)).at(key.as_ulong());
+        return v->elements().at(key.as_ulong());
     } else
         throw domain_error("dynamic value is not an array or map");
 }
 
 dynamic &dynamic::operator[](const dynamic &key) {
     if (v->t == type::MAP) {
-        if (!has(key))
-            (*(v->v.mapVal))[key] = dynamic(dynamic::type::MAP);
-        return (*(v->v.mapVal)).at(key);
+        dynamic *val = v->find(key);
+        if (val != nullptr)
+            return *val;
+        v->touch();
+        return v->insert(key, dynamic(dynamic::type::MAP));
     } else if (v->t == type::ARRAY) {
         if (key.as_ulong() >= size())
             throw range_error(fmt::format("dynamic value index out of range {} > {}",
                                           key.as_ulong(), size() - 1));
-        return (*(v->v.arrayVal)).at(key.as_ulong());
+        return v->elements().at(key.as_ulong());
     } else
         throw domain_error("dynamic value is not an array or map");
 }
@@ -839,9 +1915,10 @@ const dynamic &dynamic::at(const dynamic &key) const {
 
 dynamic &dynamic::at(const dynamic &key) {
     if (v->t == type::MAP) {
-        if (!has(key))
+        dynamic *val = v->find(key);
+        if (val == nullptr)
             throw range_error(fmt::format("dynamic value has no member: {}", key.str()));
-        return (*(v->v.mapVal)).at(key);
+        return *val;
     } else if (v->t == type::ARRAY) {
         return (*this)[key];
     } else
@@ -877,75 +1954,90 @@ const dynamic &dynamic::back() const {
 }
 
 dynamic::iterator dynamic::begin() {
+    if (v->t == dynamic::type::MAP && v->shaped)
+        return dynamic::iterator(v->v.shapedVal->shape->keys.data(), v.get());
+    if (v->t == dynamic::type::MAP && v->sharded)
+        return dynamic::iterator(&(v->v.shardedVal->maps), 0, v->v.shardedVal->maps[0].begin());
     if (v->t == dynamic::type::MAP)
-        return dynamic::iterator(v->v.mapVal->begin());
+        return dynamic::iterator(v->v.orderedVal->entries.data(),
+                                 v->v.orderedVal->entries.data() + v->v.orderedVal->entries.size());
     if (v->t == dynamic::type::ARRAY)
-        return dynamic::iterator(v->v.arrayVal->begin());
+        return dynamic::iterator(v->elements().begin());
     else
         throw domain_error("dynamic value is not an array or a map");
 }
 
 dynamic::iterator dynamic::end() {
+    if (v->t == dynamic::type::MAP && v->shaped)
+        return dynamic::iterator(v->v.shapedVal->shape->keys.data() + v->v.shapedVal->values.size(),
+                                 v.get());
+    if (v->t == dynamic::type::MAP && v->sharded)
+        return dynamic::iterator(&(v->v.shardedVal->maps), v->v.shardedVal->maps.size() - 1,
+                                 v->v.shardedVal->maps.back().end());
     if (v->t == dynamic::type::MAP)
-        return dynamic::iterator(v->v.mapVal->end());
+        return dynamic::iterator(v->v.orderedVal->entries.data() + v->v.orderedVal->entries.size(),
+                                 v->v.orderedVal->entries.data() + v->v.orderedVal->entries.size());
     if (v->t == dynamic::type::ARRAY)
-        return dynamic::iterator(v->v.arrayVal->end());
+        return dynamic::iterator(v->elements().end());
     else
         throw domain_error("dynamic value is not an array or a map");
 }
 
 dynamic::const_iterator dynamic::begin() const {
+    if (v->t == dynamic::type::MAP && v->shaped)
+        return dynamic::const_iterator(v->v.shapedVal->shape->keys.data(), v.get());
+    if (v->t == dynamic::type::MAP && v->sharded)
+        return dynamic::const_iterator(&(v->v.shardedVal->maps), 0,
+                                       v->v.shardedVal->maps[0].cbegin());
     if (v->t == dynamic::type::MAP)
-        return dynamic::const_iterator(v->v.mapVal->begin());
+        return dynamic::const_iterator(
+            v->v.orderedVal->entries.data(),
+            v->v.orderedVal->entries.data() + v->v.orderedVal->entries.size());
     if (v->t == dynamic::type::ARRAY)
-        return dynamic::const_iterator(v->v.arrayVal->begin());
+        return dynamic::const_iterator(v.get(), 0);
     else
         throw domain_error("dynamic value is not an array or a map");
 }
 
 dynamic::const_iterator dynamic::end() const {
+    if (v->t == dynamic::type::MAP && v->shaped)
+        return dynamic::const_iterator(
+            v->v.shapedVal->shape->keys.data() + v->v.shapedVal->values.size(), v.get());
+    if (v->t == dynamic::type::MAP && v->sharded)
+        return dynamic::const_iterator(&(v->v.shardedVal->maps), v->v.shardedVal->maps.size() - 1,
+                                       v->v.shardedVal->maps.back().cend());
     if (v->t == dynamic::type::MAP)
-        return dynamic::const_iterator(v->v.mapVal->end());
+        return dynamic::const_iterator(
+            v->v.orderedVal->entries.data() + v->v.orderedVal->entries.size(),
+            v->v.orderedVal->entries.data() + v->v.orderedVal->entries.size());
     if (v->t == dynamic::type::ARRAY)
-        return dynamic::const_iterator(v->v.arrayVal->end());
+        return dynamic::const_iterator(v.get(), size());
     else
         throw domain_error("dynamic value is not an array or a map");
 }
 
 dynamic::reverse_iterator dynamic::rbegin() {
-    if (v->t == dynamic::type::MAP)
-        throw domain_error("dynamic value map rbegin not implemented");
-    if (v->t == dynamic::type::ARRAY)
-        return dynamic::reverse_iterator(v->v.arrayVal->rbegin());
-    else
-        throw domain_error("dynamic value is not an array or a map");
+    if (v->t == dynamic::type::MAP && v->sharded)
+        throw domain_error("dynamic value concurrent map does not support reverse iteration");
+    return dynamic::reverse_iterator(end());
 }
 
 dynamic::reverse_iterator dynamic::rend() {
-    if (v->t == dynamic::type::MAP)
-        throw domain_error("dynamic value map rend not implemented");
-    if (v->t == dynamic::type::ARRAY)
-        return dynamic::reverse_iterator(v->v.arrayVal->rend());
-    else
-        throw domain_error("dynamic value is not an array or a map");
+    if (v->t == dynamic::type::MAP && v->sharded)
+        throw domain_error("dynamic value concurrent map does not support reverse iteration");
+    return dynamic::reverse_iterator(begin());
 }
 
 dynamic::const_reverse_iterator dynamic::rbegin() const {
-    if (v->t == dynamic::type::MAP)
-        throw domain_error("dynamic value map rbegin not implemented");
-    if (v->t == dynamic::type::ARRAY)
-        return dynamic::const_reverse_iterator(v->v.arrayVal->rbegin());
-    else
-        throw domain_error("dynamic value is not an array or a map");
+    if (v->t == dynamic::type::MAP && v->sharded)
+        throw domain_error("dynamic value concurrent map does not support reverse iteration");
+    return dynamic::const_reverse_iterator(end());
 }
 
 dynamic::const_reverse_iterator dynamic::rend() const {
-    if (v->t == dynamic::type::MAP)
-        throw domain_error("dynamic value map rend not implemented");
-    if (v->t == dynamic::type::ARRAY)
-        return dynamic::const_reverse_iterator(v->v.arrayVal->rend());
-    else
-        throw domain_error("dynamic value is not an array or a map");
+    if (v->t == dynamic::type::MAP && v->sharded)
+        throw domain_error("dynamic value concurrent map does not support reverse iteration");
+    return dynamic::const_reverse_iterator(begin());
 }
 
 dynamic::const_iterator dynamic::cbegin() const {
@@ -966,19 +2058,37 @@ dynamic::const_reverse_iterator dynamic::crend() const {
 
 void dynamic::push_back(const dynamic &val) {
     type_check(dynamic::type::ARRAY);
-    (*(v->v.arrayVal)).push_back(val);
+    v->touch();
+    if (v->is_packed() && val.v->t == v->packed->t) {
+        if (val.v->t == type::DOUBLE)
+            v->packed->doubles.push_back(val.v->v.doubleVal);
+        else
+            v->packed->longs.push_back(val.v->t == type::INT ? val.v->v.intVal : val.v->v.longVal);
+    } else
+        v->elements().push_back(val);
 }
 
 bool dynamic::has(const dynamic &key) const {
     type_check(dynamic::type::MAP);
-    return (*(v->v.mapVal)).find(key) != (*(v->v.mapVal)).end();
+    return v->find(key) != nullptr;
+}
+
+dynamic *dynamic::data() {
+    type_check(dynamic::type::ARRAY);
+    return v->elements().data();
+}
+
+const dynamic *dynamic::data() const {
+    type_check(dynamic::type::ARRAY);
+    return v->elements().data();
 }
 
 size_t dynamic::size() const {
-    if (v->t == dynamic::type::ARRAY)
-        return (*(v->v.arrayVal)).size();
-    else if (v->t == dynamic::type::MAP)
-        return (*(v->v.mapVal)).size();
+    if (v->t == dynamic::type::ARRAY) {
+        const shared_ptr<const container::packed_array> p = v->packed_values();
+        return p ? p->size() : v->v.arrayVal->size();
+    } else if (v->t == dynamic::type::MAP)
+        return v->count();
     else if (v->t == dynamic::type::STRING)
         return (*(v->v.stringVal)).size();
     else
@@ -987,9 +2097,10 @@ size_t dynamic::size() const {
 
 size_t dynamic::max_size() const {
     if (v->t == dynamic::type::ARRAY)
-        return (*(v->v.arrayVal)).max_size();
+        return v->elements().max_size();
     else if (v->t == dynamic::type::MAP)
-        return (*(v->v.mapVal)).max_size();
+        return v->sharded ? v->v.shardedVal->maps.size() * v->v.shardedVal->maps[0].max_size()
+                          : static_cast<size_t>(UINT32_MAX) - 1;
     else if (v->t == dynamic::type::STRING)
         return (*(v->v.stringVal)).max_size();
     else
@@ -997,17 +2108,18 @@ size_t dynamic::max_size() const {
 }
 
 void dynamic::resize(const size_t s) {
+    if (v->t != dynamic::type::ARRAY && v->t != dynamic::type::STRING)
+        throw domain_error("dynamic value type must be string or array to resize");
+    v->touch();
     if (v->t == dynamic::type::ARRAY)
-        (*(v->v.arrayVal)).resize(s);
-    else if (v->t == dynamic::type::STRING)
-        (*(v->v.stringVal)).resize(s);
+        v->elements().resize(s);
     else
-        throw domain_error("dynamic value type must be string or array to resize");
+        (*(v->v.stringVal)).resize(s);
 }
 
 size_t dynamic::capacity() const {
     if (v->t == dynamic::type::ARRAY)
-        return (*(v->v.arrayVal)).capacity();
+        return v->elements().capacity();
     else if (v->t == dynamic::type::STRING)
         return (*(v->v.stringVal)).capacity();
     else
@@ -1015,8 +2127,11 @@ size_t dynamic::capacity() const {
 }
 
 void dynamic::reserve(const size_t s) {
-    if (v->t == dynamic::type::ARRAY)
-        (*(v->v.arrayVal)).reserve(s);
+    if (v->t == dynamic::type::ARRAY && v->is_packed()) {
+        v->packed->longs.reserve(v->packed->t == type::DOUBLE ? 0 : s);
+        v->packed->doubles.reserve(v->packed->t == type::DOUBLE ? s : 0);
+    } else if (v->t == dynamic::type::ARRAY)
+        v->elements().reserve(s);
     else if (v->t == dynamic::type::STRING)
         (*(v->v.stringVal)).reserve(s);
     else
@@ -1024,8 +2139,11 @@ void dynamic::reserve(const size_t s) {
 }
 
 void dynamic::shrink_to_fit() {
-    if (v->t == dynamic::type::ARRAY)
-        (*(v->v.arrayVal)).shrink_to_fit();
+    if (v->t == dynamic::type::ARRAY && v->is_packed()) {
+        v->packed->longs.shrink_to_fit();
+        v->packed->doubles.shrink_to_fit();
+    } else if (v->t == dynamic::type::ARRAY)
+        v->elements().shrink_to_fit();
     else if (v->t == dynamic::type::STRING)
         (*(v->v.stringVal)).shrink_to_fit();
     else
@@ -1033,24 +2151,166 @@ void dynamic::shrink_to_fit() {
 }
 
 void dynamic::assign(const size_t s, const dynamic &val) {
-    if (v->t == type::ARRAY)
-        (*(v->v.arrayVal)).assign(s, val);
-    else
+    if (v->t != type::ARRAY)
+        throw domain_error("dynamic value type must be array to assign");
+    v->touch();
+    v->elements().assign(s, val);
+}
+
+void dynamic::assign(const int *values, const size_t count) {
+    if (v->t != type::ARRAY)
         throw domain_error("dynamic value type must be array to assign");
+    v->touch();
+    container::packed_array *p = new container::packed_array();
+    p->t                       = type::INT;
+    p->longs.assign(values, values + count);
+    v->adopt(p);
+}
+
+void dynamic::assign(const long *values, const size_t count) {
+    if (v->t != type::ARRAY)
+        throw domain_error("dynamic value type must be array to assign");
+    v->touch();
+    container::packed_array *p = new container::packed_array();
+    p->t                       = type::LONG;
+    p->longs.resize(count);
+    if (count > 0)
+        memcpy(p->longs.data(), values, count * sizeof(long));
+    v->adopt(p);
+}
+
+void dynamic::assign(const double *values, const size_t count) {
+    if (v->t != type::ARRAY)
+        throw domain_error("dynamic value type must be array to assign");
+    v->touch();
+    container::packed_array *p = new container::packed_array();
+    p->t                       = type::DOUBLE;
+    p->doubles.resize(count);
+    if (count > 0)
+        memcpy(p->doubles.data(), values, count * sizeof(double));
+    v->adopt(p);
+}
+
+bool dynamic::pack() {
+    type_check(type::ARRAY);
+    if (v->is_packed())
+        return true;
+
+    const vector<dynamic> &items = *(v->v.arrayVal);
+    if (items.empty())
+        return false;
+    const type t = items.front().get_type();
+    if (t != type::INT && t != type::LONG && t != type::DOUBLE)
+        return false;
+    for (const dynamic &d : items)
+        if (d.get_type() != t)
+            return false;
+
+    container::packed_array *p = new container::packed_array();
+    p->t                       = t;
+    if (t == type::DOUBLE) {
+        p->doubles.reserve(items.size());
+        for (const dynamic &d : items)
+            p->doubles.push_back(d.v->v.doubleVal);
+    } else {
+        p->longs.reserve(items.size());
+        for (const dynamic &d : items)
+            p->longs.push_back(t == type::INT ? d.v->v.intVal : d.v->v.longVal);
+    }
+    v->touch();
+    v->adopt(p);
+    return true;
+}
+
+bool dynamic::is_packed() const {
+    return v->t == type::ARRAY && v->is_packed();
+}
+
+double dynamic::sum() const {
+    type_check(type::ARRAY);
+    const shared_ptr<const container::packed_array> p = v->packed_values();
+    if (p && p->t == type::DOUBLE)
+        return sum_doubles(p->doubles.data(), p->doubles.size());
+    if (p)
+        return sum_longs(p->longs.data(), p->longs.size());
+
+    double ret = 0;
+    for (const dynamic &d : v->elements())
+        ret += d.as_double();
+    return ret;
+}
+
+double dynamic::min() const {
+    type_check(type::ARRAY);
+    if (empty())
+        throw range_error("dynamic value array is empty");
+    const shared_ptr<const container::packed_array> p = v->packed_values();
+    if (p && p->t == type::DOUBLE)
+        return extreme_doubles(p->doubles.data(), p->doubles.size(), false);
+    if (p)
+        return extreme_longs(p->longs.data(), p->longs.size(), false);
+
+    double ret = v->elements().front().as_double();
+    for (const dynamic &d : v->elements())
+        if (d.as_double() < ret)
+            ret = d.as_double();
+    return ret;
+}
+
+double dynamic::max() const {
+    type_check(type::ARRAY);
+    if (empty())
+        throw range_error("dynamic value array is empty");
+    const shared_ptr<const container::packed_array> p = v->packed_values();
+    if (p && p->t == type::DOUBLE)
+        return extreme_doubles(p->doubles.data(), p->doubles.size(), true);
+    if (p)
+        return extreme_longs(p->longs.data(), p->longs.size(), true);
+
+    double ret = v->elements().front().as_double();
+    for (const dynamic &d : v->elements())
+        if (d.as_double() > ret)
+            ret = d.as_double();
+    return ret;
+}
+
+double dynamic::mean() const {
+    type_check(type::ARRAY);
+    if (empty())
+        throw range_error("dynamic value array is empty");
+    return sum() / size();
 }
 
 void dynamic::pop_back() {
     type_check(type::ARRAY);
-    (*(v->v.arrayVal)).pop_back();
+    v->touch();
+    if (v->is_packed() && v->packed->t == type::DOUBLE)
+        v->packed->doubles.pop_back();
+    else if (v->is_packed())
+        v->packed->longs.pop_back();
+    else
+        v->elements().pop_back();
 }
 
 void dynamic::clear() {
-    if (v->t == dynamic::type::MAP)
-        (*(v->v.mapVal)).clear();
-    else if (v->t == dynamic::type::ARRAY)
-        (*(v->v.arrayVal)).clear();
-    else
+    if (v->t != dynamic::type::ARRAY && v->t != dynamic::type::MAP)
         throw domain_error("dynamic value is not an array or a map");
+    v->touch();
+    if (v->t == dynamic::type::MAP && v->shaped) {
+        v->v.shapedVal->shape = container::map_shape::root();
+        v->v.shapedVal->values.clear();
+    } else if (v->t == dynamic::type::MAP && v->sharded) {
+        for (size_t i = 0; i < v->v.shardedVal->maps.size(); i++) {
+            lock_guard<mutex> l(v->v.shardedVal->locks[i]);
+            v->v.shardedVal->maps[i].clear();
+        }
+    } else if (v->t == dynamic::type::MAP)
+        v->v.orderedVal->clear();
+    else if (v->t == dynamic::type::ARRAY && v->is_packed()) {
+        v->packed->longs.clear();
+        v->packed->doubles.clear();
+    } else
+        v->elements().clear();
 }
 
 bool dynamic::empty() const {
@@ -1063,22 +2323,26 @@ void dynamic::reset() {
 
 void dynamic::erase(const dynamic &key) {
     type_check(dynamic::type::MAP);
-    (*(v->v.mapVal)).erase(key);
+    v->touch();
+    v->remove(key);
 }
 
 void dynamic::erase(vector<dynamic>::const_iterator iter) {
     type_check(dynamic::type::ARRAY);
-    (*(v->v.arrayVal)).erase(iter);
+    v->touch();
+    v->elements().erase(iter);
 }
 
 void dynamic::emplace(std::vector<dynamic>::const_iterator iter, const dynamic &val) {
     type_check(dynamic::type::ARRAY);
-    (*(v->v.arrayVal)).emplace(iter, val);
+    v->touch();
+    v->elements().emplace(iter, val);
 }
 
 void dynamic::emplace_back(const dynamic &val) {
     type_check(dynamic::type::ARRAY);
-    (*(v->v.arrayVal)).emplace_back(val);
+    v->touch();
+    v->elements().emplace_back(val);
 }
 
 dynamic dynamic::deep_copy() const {
@@ -1087,16 +2351,38 @@ dynamic dynamic::deep_copy() const {
     switch (v->t) {
         case dynamic::type::MAP:
             ret.set_type(dynamic::type::MAP);
-            for (auto item : *this)
-                ret[item.key()] = item.value().deep_copy();
+            if (v->sharded) {
+                ret.v->adopt(new container::sharded_map(v->v.shardedVal->maps.size()));
+                v->entries([&ret](const dynamic &key, const dynamic &val) {
+                    ret.v->insert(key, val.deep_copy());
+                });
+                break;
+            }
+            if (v->shaped) {
+                ret.v->v.shapedVal->shape = v->v.shapedVal->shape;
+                for (size_t i = 0; i < v->v.shapedVal->values.size(); i++)
+                    ret.v->v.shapedVal->values.push_back(v->v.shapedVal->values[i].deep_copy());
+                break;
+            }
+            ret.v->adopt(new container::ordered_map(v->v.orderedVal->keep_order));
+            ret.v->v.orderedVal->entries.reserve(v->v.orderedVal->live);
+            v->entries([&ret](const dynamic &key, const dynamic &val) {
+                ret.v->insert(key, val.deep_copy());
+            });
             break;
-        case dynamic::type::ARRAY:
+        case dynamic::type::ARRAY: {
             ret.set_type(dynamic::type::ARRAY);
+            const shared_ptr<const container::packed_array> p = v->packed_values();
+            if (p) {
+                ret.v->adopt(new container::packed_array(*p));
+                break;
+            }
             for (auto item : *this) {
                 dynamic tmp(item.value().deep_copy());
                 ret.push_back(tmp);
             }
             break;
+        }
         case dynamic::type::INT:
             ret = as_int();
             break;
@@ -1135,12 +2421,408 @@ bool dynamic::is_type(const dynamic::type t) const {
     return v->t == t;
 }
 
+dynamic *dynamic::lookup(const dynamic &key) const {
+    if (v->t != type::MAP)
+        return nullptr;
+    return v->find(key);
+}
+
+dynamic *dynamic::lookup(const size_t index) const {
+    if (v->t != type::ARRAY || index >= size())
+        return nullptr;
+    return &v->elements()[index];
+}
+
+void dynamic::erase_index(const size_t index) {
+    type_check(dynamic::type::ARRAY);
+    if (index >= size())
+        throw range_error(
+            fmt::format("dynamic value index out of range {} > {}", index, size() - 1));
+    v->touch();
+    v->elements().erase(v->elements().begin() + index);
+}
+
+void dynamic::insert_index(const size_t index, const dynamic &val) {
+    type_check(dynamic::type::ARRAY);
+    if (index > size())
+        throw range_error(fmt::format("dynamic value index out of range {} > {}", index, size()));
+    v->touch();
+    v->elements().insert(v->elements().begin() + index, val);
+}
+
+dynamic dynamic::intern(const std::string &key) {
+    dynamic ret(type::NONE);
+    ret.v = container::intern(key, true);
+    return ret;
+}
+
+void dynamic::memoize(const bool enable) {
+    v->memoized = enable;
+    if (!enable)
+        v->forget();
+}
+
+bool dynamic::is_memoized() const {
+    return v->memoized;
+}
+
+bool dynamic::is_interned() const {
+    return v->atom;
+}
+
+void dynamic::detach() {
+    if (v->atom) {
+        v->invalidate();
+        v = make_shared<container>();
+    }
+}
+
+dynamic dynamic::concurrent(const size_t shards) {
+    if (shards == 0)
+        throw domain_error("dynamic concurrent map requires at least one shard");
+    dynamic ret;
+    ret.v->adopt(new container::sharded_map(shards));
+    return ret;
+}
+
+bool dynamic::is_concurrent() const {
+    return v->t == dynamic::type::MAP && v->sharded;
+}
+
+dynamic dynamic::ordered() {
+    dynamic ret;
+    ret.v->adopt(new container::ordered_map(true));
+    return ret;
+}
+
+bool dynamic::is_ordered() const {
+    return v->t == dynamic::type::MAP && v->ordered && v->v.orderedVal->keep_order;
+}
+
+bool dynamic::find(const dynamic &key, dynamic &out) const {
+    type_check(dynamic::type::MAP);
+    return v->get(key, out);
+}
+
+void dynamic::insert_or_assign(const dynamic &key, const dynamic &val) {
+    type_check(dynamic::type::MAP);
+    v->touch();
+    v->put(key, val);
+}
+
+dynamic dynamic::compute_if_absent(const dynamic &key, const function<dynamic()> &fn) {
+    type_check(dynamic::type::MAP);
+    v->touch();
+    return v->compute(key, fn);
+}
+
+dynamic dynamic::element(const size_t index) const {
+    type_check(dynamic::type::ARRAY);
+    if (index >= size())
+        throw range_error(
+            fmt::format("dynamic value index out of range {} > {}", index, size() - 1));
+    return v->element(index);
+}
+
+const std::string &dynamic::string_value() const {
+    type_check(dynamic::type::STRING);
+    return *(v->v.stringVal);
+}
+
+template <class T>
+static size_t number_hash(const char *format, const T value) {
+    char      text[32];
+    const int length = snprintf(text, sizeof(text), format, value);
+    return std::hash<string>()(string(text, static_cast<size_t>(length)));
+}
+
+size_t dynamic::hash() const {
+    const uint64_t version = v->version.load(memory_order_acquire);
+    if (v->hashed_version.load(memory_order_acquire) == version)
+        return v->hash_value.load(memory_order_relaxed);
+
+    const weak_ptr<container> self(v);
+    size_t                    ret = 0;
+    switch (v->t) {
+        case type::NONE:
+            ret = std::hash<string>()("null");
+            break;
+        case type::INT:
+            ret = number_hash("%d", v->v.intVal);
+            break;
+        case type::UINT:
+            ret = number_hash("%u", v->v.uintVal);
+            break;
+        case type::LONG:
+            ret = number_hash("%ld", v->v.longVal);
+            break;
+        case type::ULONG:
+            ret = number_hash("%lu", v->v.ulongVal);
+            break;
+        case type::DOUBLE:
+            ret = number_hash("%g", v->v.doubleVal);
+            break;
+        case type::BOOL:
+            ret = std::hash<string>()(v->v.boolVal ? "true" : "false");
+            break;
+        case type::STRING:
+            ret = std::hash<string>()(*(v->v.stringVal));
+            break;
+        case type::ARRAY: {
+            const shared_ptr<const container::packed_array> p = v->packed_values();
+
+            ret = size();
+            if (p && p->t == type::DOUBLE)
+                for (const double d : p->doubles)
+                    ret ^= number_hash("%g", d) + 0x9e3779b97f4a7c15ULL + (ret << 6) + (ret >> 2);
+            else if (p)
+                for (const long l : p->longs)
+                    ret ^= number_hash("%ld", l) + 0x9e3779b97f4a7c15ULL + (ret << 6) + (ret >> 2);
+            else
+                for (const dynamic &d : v->elements()) {
+                    ret ^= d.hash() + 0x9e3779b97f4a7c15ULL + (ret << 6) + (ret >> 2);
+                    d.v->depend(self);
+                }
+            break;
+        }
+        case type::MAP: {
+            size_t sum = 0;
+            v->entries([&sum, &self](const dynamic &key, const dynamic &val) {
+                size_t entry = key.hash();
+                entry ^= val.hash() + 0x9e3779b97f4a7c15ULL + (entry << 6) + (entry >> 2);
+                sum += entry * 0xff51afd7ed558ccdULL;
+                val.v->depend(self);
+            });
+            ret = sum ^ (size() * 0xc4ceb9fe1a85ec53ULL);
+            break;
+        }
+    }
+    v->hash_value.store(ret, memory_order_relaxed);
+    v->hashed_version.store(version, memory_order_release);
+    return ret;
+}
+
 string dynamic::str(const bool pretty) const {
+    if (v->memoized && (v->t == type::ARRAY || v->t == type::MAP)) {
+        const shared_ptr<const container::memo_entry> cached = v->fragment(pretty, 0);
+        const shared_ptr<const string>                text   = cached->text();
+        string                                        ret;
+        ret.reserve(text->size() + 1);
+        ret = *text;
+        if (!empty())
+            ret += pretty && v->t == type::MAP ? "\n" : " ";
+        return ret;
+    }
+
     ostringstream output;
     to_string(pretty, output, 0);
     return output.str();
 }
 
+static void canonical_escape(const string &str, string &out) {
+    static const char *const HEX_DIGITS = "0123456789abcdef";
+
+    out += '"';
+    size_t run = 0;
+    for (size_t i = 0; i < str.size(); i++) {
+        const unsigned char c = static_cast<unsigned char>(str[i]);
+        if (c >= 0x20 && c != '\\' && c != '"')
+            continue;
+
+        char   e[6] = {'\\', 'u', '0', '0', HEX_DIGITS[c >> 4], HEX_DIGITS[c & 0xF]};
+        size_t n    = 2;
+        switch (c) {
+            case '"':
+                e[1] = '"';
+                break;
+            case '\\':
+                e[1] = '\\';
+                break;
+            case '\b':
+                e[1] = 'b';
+                break;
+            case '\f':
+                e[1] = 'f';
+                break;
+            case '\n':
+                e[1] = 'n';
+                break;
+            case '\r':
+                e[1] = 'r';
+                break;
+            case '\t':
+                e[1] = 't';
+                break;
+            default:
+                n = 6;
+        }
+        out.append(str, run, i - run);
+        out.append(e, n);
+        run = i + 1;
+    }
+    out.append(str, run, str.size() - run);
+    out += '"';
+}
+
+static void canonical_number(const double value, string &out) {
+    if (!isfinite(value))
+        throw domain_error(fmt::format("canonical form has no representation for {}", value));
+    if (value == 0) {
+        out += '0';
+        return;
+    }
+
+    char buffer[32];
+    for (int precision = 14; precision < 17; precision++) {
+        snprintf(buffer, sizeof(buffer), "%.*e", precision, value);
+        if (strtod(buffer, nullptr) == value)
+            break;
+    }
+
+    const char *p = buffer;
+    if (*p == '-') {
+        out += '-';
+        p++;
+    }
+    char digits[24];
+    int  k = 0;
+    for (; *p != 'e'; p++)
+        if (*p != '.')
+            digits[k++] = *p;
+    while (k > 1 && digits[k - 1] == '0')
+        k--;
+
+    const int n = atoi(p + 1) + 1;
+    if (k <= n && n <= 21) {
+        out.append(digits, k);
+        out.append(n - k, '0');
+    } else if (0 < n && n <= 21) {
+        out.append(digits, n);
+        out += '.';
+        out.append(digits + n, k - n);
+    } else if (-6 < n && n <= 0) {
+        out += "0.";
+        out.append(-n, '0');
+        out.append(digits, k);
+    } else {
+        out += digits[0];
+        if (k > 1) {
+            out += '.';
+            out.append(digits + 1, k - 1);
+        }
+        out += n > 0 ? "e+" : "e-";
+        out += to_string(abs(n - 1));
+    }
+}
+
+static unsigned char utf16_rank(const unsigned char c) {
+    return c == 0xEE || c == 0xEF ? c + 0x10 : c;
+}
+
+static bool canonical_less(const string &a, const string &b) {
+    const size_t n = a.size() < b.size() ? a.size() : b.size();
+    for (size_t i = 0; i < n; i++)
+        if (a[i] != b[i])
+            return utf16_rank(static_cast<unsigned char>(a[i])) <
+                   utf16_rank(static_cast<unsigned char>(b[i]));
+    return a.size() < b.size();
+}
+
+string dynamic::canonical() const {
+    string ret;
+    canonical(ret);
+    return ret;
+}
+
+void dynamic::canonical(std::string &out) const {
+    char number[32];
+    switch (v->t) {
+        case type::NONE:
+            out += "null";
+            break;
+        case type::INT:
+            out.append(number, snprintf(number, sizeof(number), "%d", v->v.intVal));
+            break;
+        case type::UINT:
+            out.append(number, snprintf(number, sizeof(number), "%u", v->v.uintVal));
+            break;
+        case type::LONG:
+            out.append(number, snprintf(number, sizeof(number), "%ld", v->v.longVal));
+            break;
+        case type::ULONG:
+            out.append(number, snprintf(number, sizeof(number), "%lu", v->v.ulongVal));
+            break;
+        case type::DOUBLE:
+            canonical_number(v->v.doubleVal, out);
+            break;
+        case type::BOOL:
+            out += v->v.boolVal ? "true" : "false";
+            break;
+        case type::STRING:
+            canonical_escape(*(v->v.stringVal), out);
+            break;
+        case type::ARRAY: {
+            const shared_ptr<const container::packed_array> p = v->packed_values();
+            out += '[';
+            if (p && p->t == type::DOUBLE)
+                for (size_t i = 0; i < p->size(); i++) {
+                    if (i > 0)
+                        out += ',';
+                    canonical_number(p->doubles[i], out);
+                }
+            else if (p)
+                for (size_t i = 0; i < p->size(); i++) {
+                    if (i > 0)
+                        out += ',';
+                    out.append(number, snprintf(number, sizeof(number), "%ld", p->longs[i]));
+                }
+            else
+                for (size_t i = 0; i < v->v.arrayVal->size(); i++) {
+                    if (i > 0)
+                        out += ',';
+                    (*(v->v.arrayVal))[i].canonical(out);
+                }
+            out += ']';
+            break;
+        }
+        case type::MAP: {
+            vector<pair<dynamic, dynamic>>                 held;
+            vector<pair<const dynamic *, const dynamic *>> items;
+            items.reserve(size());
+            v->entries([this, &held, &items](const dynamic &key, const dynamic &val) {
+                if (!key.is_string())
+                    throw domain_error(fmt::format("canonical map keys must be strings, got {}",
+                                                   TYPE_NAME.at(key.get_type())));
+                if (v->sharded)
+                    held.emplace_back(key, val);
+                else
+                    items.emplace_back(&key, &val);
+            });
+            for (const auto &p : held)
+                items.emplace_back(&p.first, &p.second);
+
+            std::sort(items.begin(), items.end(),
+                  [](const pair<const dynamic *, const dynamic *> &a,
+                     const pair<const dynamic *, const dynamic *> &b) {
+                      return canonical_less(a.first->string_value(), b.first->string_value());
+                  });
+
+            out += '{';
+            for (size_t i = 0; i < items.size(); i++) {
+                if (i > 0)
+                    out += ',';
+                canonical_escape(items[i].first->string_value(), out);
+                out += ':';
+                items[i].second->canonical(out);
+            }
+            out += '}';
+            break;
+        }
+        default:
+            break;
+    }
+}
+
 void dynamic::to_string(const bool pretty, std::ostream &s, const size_t indent) const {
     switch (v->t) {
         case type::NONE:
@@ -1173,10 +2855,7 @@ void dynamic::to_string(const bool pretty, std::ostream &s, const size_t indent)
         case type::ARRAY:
             s << "[";
             if (size() > 0) {
-                for (const dynamic &d : *(v->v.arrayVal)) {
-                    d.to_string(pretty, s, indent);
-                    s << ", ";
-                }
+                elements_to_string(pretty, s, indent, 0, size());
                 s.seekp(s.tellp() - (streamoff)2);
             }
             s << "]";
@@ -1186,17 +2865,17 @@ void dynamic::to_string(const bool pretty, std::ostream &s, const size_t indent)
             if (size() > 0) {
                 if (pretty)
                     s << '\n';
-                for (const auto &p : *(v->v.mapVal)) {
+                v->entries([pretty, &s, indent](const dynamic &key, const dynamic &val) {
                     if (pretty)
                         for (size_t i = 0; i <= indent; i++)
                             s << "    ";
-                    p.first.to_string(pretty, s, indent);
+                    key.to_string(pretty, s, indent);
                     s << ": ";
-                    p.second.to_string(pretty, s, indent + 1);
+                    val.to_string(pretty, s, indent + 1);
                     s << ", ";
                     if (pretty)
                         s << '\n';
-                }
+                });
                 if (pretty)
                     s.seekp(s.tellp() - (streamoff)3);
                 else
@@ -1214,6 +2893,169 @@ void dynamic::to_string(const bool pretty, std::ostream &s, const size_t indent)
     }
 }
 
+template <class Put, class Child>
+void dynamic::container::render(const bool pretty, const size_t indent, Put put,
+                                Child child) const {
+    char number[32];
+    switch (t) {
+        case type::NONE:
+            put("null", 4);
+            break;
+        case type::INT:
+            put(number, snprintf(number, sizeof(number), "%d", v.intVal));
+            break;
+        case type::UINT:
+            put(number, snprintf(number, sizeof(number), "%u", v.uintVal));
+            break;
+        case type::LONG:
+            put(number, snprintf(number, sizeof(number), "%ld", v.longVal));
+            break;
+        case type::ULONG:
+            put(number, snprintf(number, sizeof(number), "%lu", v.ulongVal));
+            break;
+        case type::DOUBLE:
+            put(number, snprintf(number, sizeof(number), "%g", v.doubleVal));
+            break;
+        case type::BOOL:
+            if (v.boolVal)
+                put("true", 4);
+            else
+                put("false", 5);
+            break;
+        case type::STRING:
+            escape(*(v.stringVal), put);
+            break;
+        case type::ARRAY: {
+            const shared_ptr<const packed_array> p = packed_values();
+            put("[", 1);
+            if (p && p->t == type::DOUBLE)
+                for (size_t i = 0; i < p->size(); i++) {
+                    if (i > 0)
+                        put(", ", 2);
+                    put(number, snprintf(number, sizeof(number), "%g", p->doubles[i]));
+                }
+            else if (p)
+                for (size_t i = 0; i < p->size(); i++) {
+                    if (i > 0)
+                        put(", ", 2);
+                    put(number, snprintf(number, sizeof(number), "%ld", p->longs[i]));
+                }
+            else
+                for (size_t i = 0; i < v.arrayVal->size(); i++) {
+                    if (i > 0)
+                        put(", ", 2);
+                    child((*(v.arrayVal))[i], indent);
+                }
+            put("]", 1);
+            break;
+        }
+        case type::MAP: {
+            put("{", 1);
+            const string prefix(pretty ? (indent + 1) * 4 : 0, ' ');
+            bool         first = true;
+            entries([&](const dynamic &key, const dynamic &val) {
+                if (!first)
+                    put(", ", 2);
+                if (pretty) {
+                    put("\n", 1);
+                    put(prefix.data(), prefix.size());
+                }
+                child(key, indent);
+                put(": ", 2);
+                child(val, indent + 1);
+                first = false;
+            });
+            if (pretty && !first) {
+                put("\n", 1);
+                put(prefix.data(), prefix.size() - 4);
+            }
+            put("}", 1);
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+shared_ptr<const dynamic::container::memo_entry> dynamic::container::fragment(const bool   pretty,
+                                                                              const size_t indent) {
+    const uint64_t               current = version.load(memory_order_acquire);
+    shared_ptr<const memo_entry> cached  = atomic_load(&memo);
+    if (cached && cached->pretty == pretty && cached->indent == indent && cached->version == current)
+        return cached;
+
+    const weak_ptr<container> self(shared_from_this());
+    shared_ptr<memo_entry>    ret = make_shared<memo_entry>();
+    ret->version                  = current;
+    ret->indent                   = indent;
+    ret->pretty                   = pretty;
+    ret->size                     = 0;
+    ret->bytes.reserve(cached ? cached->bytes.size() : 0);
+
+    memo_entry &entry = *ret;
+    auto        put   = [&entry](const char *data, const size_t size) {
+        entry.bytes.append(data, size);
+    };
+    render(pretty, indent, put, [&entry, &put, &self, pretty](const dynamic &d, const size_t i) {
+        d.v->depend(self);
+        if (d.v->t == type::ARRAY || d.v->t == type::MAP) {
+            const shared_ptr<const memo_entry> child = d.v->fragment(pretty, i);
+            entry.nested.emplace_back(entry.bytes.size(), child);
+            entry.size += child->size;
+        } else
+            d.v->render(pretty, i, put, [](const dynamic &, const size_t) {});
+    });
+    entry.size += entry.bytes.size();
+
+    atomic_store(&memo, shared_ptr<const memo_entry>(ret));
+    return ret;
+}
+
+void dynamic::serialize(dynamic_stream &out, const bool pretty, const size_t indent) const {
+    if (v->memoized && (v->t == type::ARRAY || v->t == type::MAP)) {
+        const shared_ptr<const container::memo_entry> cached = v->fragment(pretty, indent);
+        cached->write([&out](const char *data, const size_t size) { out.write(data, size); });
+        return;
+    }
+    v->render(pretty, indent, [&out](const char *data, const size_t size) { out.write(data, size); },
+              [&out, pretty](const dynamic &d, const size_t i) { d.serialize(out, pretty, i); });
+}
+
+void dynamic::serialize(std::string &out, const bool pretty, const size_t indent,
+                        const std::function<bool(const dynamic &, const size_t)> &hook) const {
+    if (hook && hook(*this, indent))
+        return;
+    v->render(pretty, indent, [&out](const char *data, const size_t size) { out.append(data, size); },
+              [&out, pretty, &hook](const dynamic &d, const size_t i) {
+                  d.serialize(out, pretty, i, hook);
+              });
+}
+
+void dynamic::serialize(dynamic_stream &out, const std::string &str) {
+    escape(str, [&out](const char *data, const size_t size) { out.write(data, size); });
+}
+
+void dynamic::elements_to_string(const bool pretty, std::ostream &s, const size_t indent,
+                                 const size_t begin, const size_t end) const {
+    const shared_ptr<const container::packed_array> p = v->packed_values();
+    if (p && p->t == type::DOUBLE)
+        for (size_t i = begin; i < end; i++)
+            s << p->doubles[i] << ", ";
+    else if (p && p->t == type::INT)
+        for (size_t i = begin; i < end; i++)
+            s << static_cast<int>(p->longs[i]) << ", ";
+    else if (p)
+        for (size_t i = begin; i < end; i++)
+            s << p->longs[i] << ", ";
+    else {
+        const vector<dynamic> &items = v->elements();
+        for (size_t i = begin; i < end; i++) {
+            items[i].to_string(pretty, s, indent);
+            s << ", ";
+        }
+    }
+}
+
 ostream &njones::operator<<(ostream &stream, const dynamic &d) {
     stream << d.str() << endl;
     return stream;
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <functional>
 #include <memory>
 #include <sstream>
 #include <string>
@@ -11,6 +12,8 @@ namespace njones {
     class const_dynamic_iterator;
     class reverse_dynamic_iterator;
     class const_reverse_dynamic_iterator;
+    class frozen_document;
+    class dynamic_stream;
 
     class dynamic {
        public:
@@ -19,6 +22,8 @@ namespace njones {
         typedef reverse_dynamic_iterator       reverse_iterator;
         typedef const_reverse_dynamic_iterator const_reverse_iterator;
 
+        class pointer;
+
         enum class type { NONE = 0, INT, UINT, LONG, ULONG, DOUBLE, BOOL, STRING, ARRAY, MAP };
 
         dynamic();
@@ -27,7 +32,7 @@ namespace njones {
         dynamic(const type t);
 
         template <class T>
-        dynamic(const T &val) : dynamic() {
+        dynamic(const T &val) : dynamic(type::NONE) {
             *this = val;
         }
 
@@ -91,8 +96,13 @@ namespace njones {
         const dynamic &front() const;
         dynamic &      back();
         const dynamic &back() const;
+        dynamic        element(const size_t index) const;
 
         bool has(const dynamic &key) const;
+        bool find(const dynamic &key, dynamic &out) const;
+
+        void    insert_or_assign(const dynamic &key, const dynamic &val);
+        dynamic compute_if_absent(const dynamic &key, const std::function<dynamic()> &fn);
 
         dynamic::iterator               begin();
         dynamic::iterator               end();
@@ -115,6 +125,9 @@ namespace njones {
             push_back(d);
         }
 
+        dynamic *      data();
+        const dynamic *data() const;
+
         size_t size() const;
         size_t max_size() const;
         void   resize(const size_t s);
@@ -122,6 +135,9 @@ namespace njones {
         void   reserve(const size_t s);
         void   shrink_to_fit();
         void   assign(const size_t s, const dynamic &val);
+        void   assign(const int *values, const size_t count);
+        void   assign(const long *values, const size_t count);
+        void   assign(const double *values, const size_t count);
 
         template <class InputIterator>
         void assign(InputIterator first, InputIterator last) {
@@ -131,6 +147,14 @@ namespace njones {
                 push_back(*first++);
         }
 
+        bool pack();
+        bool is_packed() const;
+
+        double sum() const;
+        double min() const;
+        double max() const;
+        double mean() const;
+
         void pop_back();
 
         bool empty() const;
@@ -158,6 +182,41 @@ namespace njones {
         dynamic deep_copy() const;
 
         std::string str(const bool pretty = false) const;
+        std::string canonical() const;
+        void        canonical(std::string &out) const;
+
+        void memoize(const bool enable = true);
+        bool is_memoized() const;
+
+        frozen_document freeze() const;
+
+        void        save_snapshot(std::ostream &s) const;
+        std::string save_snapshot() const;
+
+        size_t hash() const;
+
+        static dynamic intern(const std::string &key);
+        bool           is_interned() const;
+
+        static dynamic concurrent(const size_t shards = 16);
+        bool           is_concurrent() const;
+
+        static dynamic ordered();
+        bool           is_ordered() const;
+
+        static dynamic diff(const dynamic &from, const dynamic &to);
+        void           apply_patch(const dynamic &patch);
+        void           merge_patch(dynamic &&patch);
+
+        static int compare(const dynamic &a, const dynamic &b);
+
+        void sort();
+        void sort(const pointer &key);
+        void stable_sort();
+        void stable_sort(const pointer &key);
+
+        dynamic        to_columns() const;
+        static dynamic from_columns(const dynamic &table);
 
        private:
         struct container;
@@ -167,10 +226,39 @@ namespace njones {
 
         void type_check(const type t) const;
 
+        dynamic *lookup(const dynamic &key) const;
+        dynamic *lookup(const size_t index) const;
+        void     erase_index(const size_t index);
+        void     insert_index(const size_t index, const dynamic &val);
+
+        void detach();
+
+        const std::string &string_value() const;
+
+        static void diff(const dynamic &from, const dynamic &to, const std::string &path,
+                         dynamic &patch);
+        static bool identical(const dynamic &a, const dynamic &b);
+
+        void sort_array(const pointer *key, const bool stable);
+
         bool is_type(const type t) const;
 
         void to_string(const bool pretty, std::ostream &s, const size_t indent) const;
-
+        void        serialize(dynamic_stream &out, const bool pretty, const size_t indent) const;
+        static void serialize(dynamic_stream &out, const std::string &str);
+        void        serialize(std::string &out, const bool pretty, const size_t indent,
+                              const std::function<bool(const dynamic &, const size_t)> &hook =
+                                  std::function<bool(const dynamic &, const size_t)>()) const;
+        void elements_to_string(const bool pretty, std::ostream &s, const size_t indent,
+                                const size_t begin, const size_t end) const;
+
+        friend class jsonpath;
+        friend class dynamic_iterator;
+        friend class const_dynamic_iterator;
+        friend class parallel;
+        friend class dynamic_stream;
+        friend class dynamic_writer;
+        friend class dynamic_template;
         friend std::ostream &operator<<(std::ostream &stream, const dynamic &d);
     };
 }  // namespace njones
@@ -179,7 +267,7 @@ namespace std {
     template <>
     struct hash<njones::dynamic> {
         std::size_t operator()(const njones::dynamic &d) const {
-            return hash<string>()(d.str());
+            return d.hash();
         }
     };
 }  // namespace std
@@ -189,24 +277,26 @@ namespace njones {
        public:
         dynamic_iterator_value(const dynamic &key, dynamic *v);
 
-        dynamic key() const;
+        const dynamic &key() const;
 
         dynamic &value() const;
 
        private:
-        dynamic  _key;
-        dynamic *v;
+        const dynamic *_key;
+        dynamic *      v;
     };
 
     class const_dynamic_iterator_value {
        public:
         const_dynamic_iterator_value(const dynamic &key, const dynamic *v);
-        dynamic        key() const;
+        const_dynamic_iterator_value(const dynamic &key, const std::shared_ptr<const dynamic> &item);
+        const dynamic &key() const;
         const dynamic &value() const;
 
        private:
-        dynamic        _key;
-        const dynamic *v;
+        const dynamic *                _key;
+        const dynamic *                v;
+        std::shared_ptr<const dynamic> item;
     };
 
     class dynamic_iterator
@@ -215,7 +305,12 @@ namespace njones {
         typedef dynamic_iterator_value value;
 
         dynamic_iterator(std::vector<dynamic>::iterator arrayIter);
-        dynamic_iterator(std::unordered_map<dynamic, dynamic>::iterator mapIter);
+        dynamic_iterator(const dynamic *keyIter, dynamic::container *owner);
+        dynamic_iterator(std::vector<std::unordered_map<dynamic, dynamic>> *shards,
+                         const size_t                                       shard,
+                         std::unordered_map<dynamic, dynamic>::iterator     mapIter);
+        dynamic_iterator(std::pair<dynamic, dynamic *> *entryIter,
+                         std::pair<dynamic, dynamic *> *entryEnd);
         dynamic_iterator(const dynamic_iterator &other);
         ~dynamic_iterator();
 
@@ -231,7 +326,13 @@ namespace njones {
        protected:
         dynamic::type                                  t;
         std::vector<dynamic>::iterator                 arrayIter;
-        std::unordered_map<dynamic, dynamic>::iterator mapIter;
+        std::unordered_map<dynamic, dynamic>::iterator     mapIter;
+        const dynamic *                                    keyIter;
+        dynamic::container *                               owner;
+        std::vector<std::unordered_map<dynamic, dynamic>> *shards;
+        size_t                                             shard;
+        std::pair<dynamic, dynamic *> *                    entryIter;
+        std::pair<dynamic, dynamic *> *                    entryEnd;
     };
 
     class const_dynamic_iterator
@@ -240,7 +341,13 @@ namespace njones {
         typedef const_dynamic_iterator_value value;
 
         const_dynamic_iterator(std::vector<dynamic>::const_iterator arrayIter);
-        const_dynamic_iterator(std::unordered_map<dynamic, dynamic>::const_iterator mapIter);
+        const_dynamic_iterator(const dynamic::container *owner, const size_t index);
+        const_dynamic_iterator(const dynamic *keyIter, const dynamic::container *owner);
+        const_dynamic_iterator(const std::vector<std::unordered_map<dynamic, dynamic>> *shards,
+                               const size_t                                             shard,
+                               std::unordered_map<dynamic, dynamic>::const_iterator     mapIter);
+        const_dynamic_iterator(const std::pair<dynamic, dynamic *> *entryIter,
+                               const std::pair<dynamic, dynamic *> *entryEnd);
         const_dynamic_iterator(const const_dynamic_iterator &other);
         ~const_dynamic_iterator();
 
@@ -255,7 +362,14 @@ namespace njones {
        protected:
         dynamic::type                                        t;
         std::vector<dynamic>::const_iterator                 arrayIter;
-        std::unordered_map<dynamic, dynamic>::const_iterator mapIter;
+        std::unordered_map<dynamic, dynamic>::const_iterator     mapIter;
+        const dynamic *                                          keyIter;
+        const dynamic::container *                               owner;
+        const std::vector<std::unordered_map<dynamic, dynamic>> *shards;
+        size_t                                                   shard;
+        const std::pair<dynamic, dynamic *> *                    entryIter;
+        const std::pair<dynamic, dynamic *> *                    entryEnd;
+        size_t                                                   index;
     };
 
     class reverse_dynamic_iterator {
@@ -263,6 +377,7 @@ namespace njones {
         typedef dynamic_iterator_value value;
 
         reverse_dynamic_iterator(std::vector<dynamic>::reverse_iterator arrayIter);
+        reverse_dynamic_iterator(const dynamic_iterator &current);
         reverse_dynamic_iterator(const reverse_dynamic_iterator &other);
         ~reverse_dynamic_iterator();
 
@@ -276,8 +391,7 @@ namespace njones {
         dynamic::reverse_iterator::value operator*();
 
        protected:
-        dynamic::type                          t;
-        std::vector<dynamic>::reverse_iterator arrayIter;
+        dynamic_iterator current;
     };
 
     class const_reverse_dynamic_iterator {
@@ -285,6 +399,7 @@ namespace njones {
         typedef const_dynamic_iterator_value value;
 
         const_reverse_dynamic_iterator(std::vector<dynamic>::const_reverse_iterator arrayIter);
+        const_reverse_dynamic_iterator(const const_dynamic_iterator &current);
         const_reverse_dynamic_iterator(const const_reverse_dynamic_iterator &other);
         ~const_reverse_dynamic_iterator();
 
@@ -298,8 +413,7 @@ namespace njones {
         dynamic::const_reverse_iterator::value operator*();
 
        protected:
-        dynamic::type                                t;
-        std::vector<dynamic>::const_reverse_iterator arrayIter;
+        const_dynamic_iterator current;
     };
 
     std::ostream &operator<<(std::ostream &stream, const dynamic &d);
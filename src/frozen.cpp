@@ -0,0 +1,326 @@
+#include "frozen.hpp"
+
+#define FMT_HEADER_ONLY
+
+#include <fmt/format.h>
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+using namespace std;
+using namespace njones;
+
+const size_t frozen_document::LINEAR_KEYS = 8;
+
+const char *const frozen_value::NAME = "frozen value";
+
+frozen_value::frozen_value() : doc(nullptr), index(0) {
+}
+
+frozen_value::frozen_value(const frozen_document *doc, const size_t index)
+    : doc(doc), index(index) {
+}
+
+dynamic::type frozen_value::get_type() const {
+    if (doc == nullptr)
+        return dynamic::type::NONE;
+    return doc->nodes[index].t;
+}
+
+const char *frozen_value::c_str() const {
+    type_check(dynamic::type::STRING);
+    return doc->arena.data() + doc->nodes[index].payload;
+}
+
+frozen_value frozen_value::operator[](const size_t i) const {
+    type_check(dynamic::type::ARRAY);
+    const size_t count = doc->nodes[index].size;
+    if (i >= count)
+        throw range_error(fmt::format("frozen value index out of range {} > {}", i, count - 1));
+    return frozen_value(doc, doc->nodes[index].payload + i);
+}
+
+frozen_value frozen_value::operator[](const std::string &key) const {
+    return at(key.data(), key.size());
+}
+
+frozen_value frozen_value::at(const size_t i) const {
+    return (*this)[i];
+}
+
+frozen_value frozen_value::at(const std::string &key) const {
+    return at(key.data(), key.size());
+}
+
+frozen_value frozen_value::at(const char *key, const size_t size) const {
+    frozen_value ret;
+    if (!find(key, size, ret))
+        throw range_error(fmt::format("frozen value has no member: {}", string(key, size)));
+    return ret;
+}
+
+frozen_value frozen_value::front() const {
+    return at(0);
+}
+
+frozen_value frozen_value::back() const {
+    return at(size() - 1);
+}
+
+bool frozen_value::has(const std::string &key) const {
+    return has(key.data(), key.size());
+}
+
+bool frozen_value::has(const char *key, const size_t size) const {
+    frozen_value ret;
+    return find(key, size, ret);
+}
+
+frozen_value::iterator frozen_value::begin() const {
+    const dynamic::type t = get_type();
+    if (t != dynamic::type::ARRAY && t != dynamic::type::MAP)
+        throw domain_error("frozen value is not an array or a map");
+    return frozen_iterator(doc, doc->nodes[index].payload, t == dynamic::type::MAP);
+}
+
+frozen_value::iterator frozen_value::end() const {
+    const dynamic::type t     = get_type();
+    const size_t        width = t == dynamic::type::MAP ? 2 : 1;
+    if (t != dynamic::type::ARRAY && t != dynamic::type::MAP)
+        throw domain_error("frozen value is not an array or a map");
+    return frozen_iterator(doc, doc->nodes[index].payload + width * doc->nodes[index].size,
+                           t == dynamic::type::MAP);
+}
+
+frozen_value::iterator frozen_value::cbegin() const {
+    return begin();
+}
+
+frozen_value::iterator frozen_value::cend() const {
+    return end();
+}
+
+size_t frozen_value::size() const {
+    switch (get_type()) {
+        case dynamic::type::STRING:
+        case dynamic::type::ARRAY:
+        case dynamic::type::MAP:
+            return doc->nodes[index].size;
+        default:
+            throw domain_error("frozen value type must be string, array, or map to have a size");
+    }
+}
+
+std::string frozen_value::str(const bool pretty) const {
+    return to_dynamic().str(pretty);
+}
+
+uint64_t frozen_value::scalar() const {
+    return doc->nodes[index].payload;
+}
+
+void frozen_value::type_check(const dynamic::type t) const {
+    if (get_type() != t)
+        throw domain_error("frozen value has the wrong type for this operation");
+}
+
+bool frozen_value::find(const char *key, const size_t size, frozen_value &out) const {
+    type_check(dynamic::type::MAP);
+    const frozen_document::node &n = doc->nodes[index];
+
+    if (n.size <= frozen_document::LINEAR_KEYS) {
+        for (size_t i = 0; i < n.size; i++)
+            if (doc->compare_key(n.payload + 2 * i, key, size) == 0) {
+                out = frozen_value(doc, n.payload + 2 * i + 1);
+                return true;
+            }
+        return false;
+    }
+
+    const uint32_t *first = doc->key_index.data() + n.keys + 1;
+    const uint32_t *last  = first + doc->key_index[n.keys];
+    while (first < last) {
+        const uint32_t *mid = first + (last - first) / 2;
+        const int       c   = doc->compare_key(n.payload + 2 * *mid, key, size);
+        if (c == 0) {
+            out = frozen_value(doc, n.payload + 2 * *mid + 1);
+            return true;
+        }
+        if (c < 0)
+            first = mid + 1;
+        else
+            last = mid;
+    }
+    return false;
+}
+
+frozen_iterator_value::frozen_iterator_value(const frozen_value &key, const frozen_value &v)
+    : _key(key), v(v) {
+}
+
+const frozen_value &frozen_iterator_value::key() const {
+    return _key;
+}
+
+const frozen_value &frozen_iterator_value::value() const {
+    return v;
+}
+
+frozen_iterator::frozen_iterator(const frozen_document *doc, const size_t index, const bool map)
+    : doc(doc), index(index), map(map) {
+}
+
+frozen_iterator &frozen_iterator::operator++() {
+    index += map ? 2 : 1;
+    return *this;
+}
+
+frozen_iterator frozen_iterator::operator++(int) {
+    frozen_iterator tmp(*this);
+    ++(*this);
+    return tmp;
+}
+
+frozen_iterator &frozen_iterator::operator--() {
+    index -= map ? 2 : 1;
+    return *this;
+}
+
+frozen_iterator frozen_iterator::operator--(int) {
+    frozen_iterator tmp(*this);
+    --(*this);
+    return tmp;
+}
+
+bool frozen_iterator::operator==(const frozen_iterator &rhs) const {
+    return doc == rhs.doc && index == rhs.index;
+}
+
+bool frozen_iterator::operator!=(const frozen_iterator &rhs) const {
+    return !(*this == rhs);
+}
+
+frozen_iterator::value frozen_iterator::operator*() const {
+    if (map)
+        return frozen_iterator_value(frozen_value(doc, index), frozen_value(doc, index + 1));
+    return frozen_iterator_value(frozen_value(), frozen_value(doc, index));
+}
+
+frozen_document::frozen_document() {
+    nodes.resize(1);
+    build(0, dynamic(nullptr));
+}
+
+frozen_document::frozen_document(const dynamic &d) {
+    nodes.resize(1);
+    build(0, d);
+    nodes.shrink_to_fit();
+    key_index.shrink_to_fit();
+    arena.shrink_to_fit();
+}
+
+frozen_value frozen_document::root() const {
+    return frozen_value(this, 0);
+}
+
+frozen_value frozen_document::operator[](const size_t index) const {
+    return root()[index];
+}
+
+frozen_value frozen_document::operator[](const std::string &key) const {
+    return root()[key];
+}
+
+dynamic frozen_document::to_dynamic() const {
+    return root().to_dynamic();
+}
+
+size_t frozen_document::node_count() const {
+    return nodes.size();
+}
+
+size_t frozen_document::arena_size() const {
+    return arena.size();
+}
+
+void frozen_document::build(const size_t at, const dynamic &d) {
+    node n = node();
+    n.t    = d.get_type();
+
+    switch (n.t) {
+        case dynamic::type::NONE:
+            break;
+        case dynamic::type::INT:
+        case dynamic::type::LONG:
+            n.payload = static_cast<uint64_t>(d.as_long());
+            break;
+        case dynamic::type::UINT:
+        case dynamic::type::ULONG:
+            n.payload = d.as_ulong();
+            break;
+        case dynamic::type::DOUBLE: {
+            const double val = d.as_double();
+            memcpy(&n.payload, &val, sizeof(val));
+            break;
+        }
+        case dynamic::type::BOOL:
+            n.payload = d.as_bool() ? 1 : 0;
+            break;
+        case dynamic::type::STRING: {
+            const string val = d.as_string();
+            if (val.size() > UINT32_MAX)
+                throw length_error("frozen string is too large");
+            n.payload = arena.size();
+            n.size    = static_cast<uint32_t>(val.size());
+            arena.append(val);
+            arena.push_back('\0');
+            break;
+        }
+        case dynamic::type::ARRAY:
+        case dynamic::type::MAP: {
+            const size_t width = d.is_map() ? 2 : 1;
+            if (d.size() > UINT32_MAX || nodes.size() + width * d.size() > UINT32_MAX)
+                throw length_error("frozen document is too large");
+            n.payload = nodes.size();
+            n.size    = static_cast<uint32_t>(d.size());
+            nodes.resize(nodes.size() + width * d.size());
+
+            size_t i = n.payload;
+            for (const auto item : d) {
+                if (d.is_map())
+                    build(i++, item.key());
+                build(i++, item.value());
+            }
+
+            if (d.is_map() && n.size > LINEAR_KEYS) {
+                vector<uint32_t> order;
+                for (uint32_t e = 0; e < n.size; e++)
+                    if (nodes[n.payload + 2 * e].t == dynamic::type::STRING)
+                        order.push_back(e);
+                std::sort(order.begin(), order.end(), [this, &n](uint32_t a, uint32_t b) {
+                    const node &k = nodes[n.payload + 2 * b];
+                    return compare_key(n.payload + 2 * a, arena.data() + k.payload, k.size) < 0;
+                });
+                n.keys = static_cast<uint32_t>(key_index.size());
+                key_index.push_back(static_cast<uint32_t>(order.size()));
+                key_index.insert(key_index.end(), order.begin(), order.end());
+            }
+            break;
+        }
+    }
+    nodes[at] = n;
+}
+
+int frozen_document::compare_key(const size_t at, const char *key, const size_t size) const {
+    const node &k = nodes[at];
+    if (k.t != dynamic::type::STRING)
+        return -1;
+    const int c = memcmp(arena.data() + k.payload, key, std::min<size_t>(k.size, size));
+    if (c != 0)
+        return c;
+    return k.size < size ? -1 : (k.size > size ? 1 : 0);
+}
+
+frozen_document dynamic::freeze() const {
+    return frozen_document(*this);
+}
@@ -0,0 +1,137 @@
+#pragma once
+
+#include <cstdint>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "dynamic.hpp"
+#include "read_only.hpp"
+
+namespace njones {
+    class frozen_document;
+    class frozen_iterator;
+
+    class frozen_value : public read_only_value<frozen_value> {
+       public:
+        typedef frozen_iterator iterator;
+        typedef frozen_iterator const_iterator;
+
+        frozen_value();
+        frozen_value(const frozen_document *doc, const size_t index);
+
+        dynamic::type get_type() const;
+
+        const char *c_str() const;
+
+        frozen_value operator[](const size_t index) const;
+        frozen_value operator[](const std::string &key) const;
+        frozen_value at(const size_t index) const;
+        frozen_value at(const std::string &key) const;
+        frozen_value at(const char *key, const size_t size) const;
+        frozen_value front() const;
+        frozen_value back() const;
+
+        bool has(const std::string &key) const;
+        bool has(const char *key, const size_t size) const;
+
+        iterator begin() const;
+        iterator end() const;
+        iterator cbegin() const;
+        iterator cend() const;
+
+        size_t size() const;
+
+        std::string str(const bool pretty = false) const;
+
+       private:
+        friend class read_only_value<frozen_value>;
+
+        static const char *const NAME;
+
+        const frozen_document *doc;
+        size_t                 index;
+
+        uint64_t scalar() const;
+        template <class F>
+        void     items(F fn) const;
+        void     type_check(const dynamic::type t) const;
+        bool     find(const char *key, const size_t size, frozen_value &out) const;
+    };
+
+    class frozen_iterator_value {
+       public:
+        frozen_iterator_value(const frozen_value &key, const frozen_value &v);
+
+        const frozen_value &key() const;
+        const frozen_value &value() const;
+
+       private:
+        frozen_value _key;
+        frozen_value v;
+    };
+
+    class frozen_iterator
+        : public std::iterator<std::bidirectional_iterator_tag, frozen_iterator_value> {
+       public:
+        typedef frozen_iterator_value value;
+
+        frozen_iterator(const frozen_document *doc, const size_t index, const bool map);
+
+        frozen_iterator &operator++();
+        frozen_iterator  operator++(int);
+        frozen_iterator &operator--();
+        frozen_iterator  operator--(int);
+        bool             operator==(const frozen_iterator &rhs) const;
+        bool             operator!=(const frozen_iterator &rhs) const;
+
+        frozen_iterator::value operator*() const;
+
+       private:
+        const frozen_document *doc;
+        size_t                 index;
+        bool                   map;
+    };
+
+    class frozen_document {
+       public:
+        frozen_document();
+        frozen_document(const dynamic &d);
+
+        frozen_value root() const;
+
+        frozen_value operator[](const size_t index) const;
+        frozen_value operator[](const std::string &key) const;
+
+        dynamic to_dynamic() const;
+
+        size_t node_count() const;
+        size_t arena_size() const;
+
+       private:
+        friend class frozen_value;
+        friend class frozen_iterator;
+
+        struct node {
+            uint64_t      payload;
+            uint32_t      size;
+            uint32_t      keys;
+            dynamic::type t;
+        };
+
+        static const size_t LINEAR_KEYS;
+
+        std::vector<node>     nodes;
+        std::vector<uint32_t> key_index;
+        std::string           arena;
+
+        void build(const size_t at, const dynamic &d);
+        int  compare_key(const size_t at, const char *key, const size_t size) const;
+    };
+
+    template <class F>
+    void frozen_value::items(F fn) const {
+        for (const auto item : *this)
+            fn(item.key(), item.value());
+    }
+}  // namespace njones
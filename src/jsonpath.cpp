@@ -0,0 +1,584 @@
+#include "jsonpath.hpp"
+
+#define FMT_HEADER_ONLY
+
+#include <fmt/format.h>
+#include <cctype>
+#include <climits>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+
+#include "parallel.hpp"
+
+using namespace std;
+using namespace njones;
+
+const size_t jsonpath::PARALLEL_THRESHOLD = 4096;
+
+static const int UNORDERED = 2;
+
+static bool is_number(const dynamic &d) {
+    switch (d.get_type()) {
+        case dynamic::type::INT:
+        case dynamic::type::UINT:
+        case dynamic::type::LONG:
+        case dynamic::type::ULONG:
+        case dynamic::type::DOUBLE:
+            return true;
+        default:
+            return false;
+    }
+}
+
+static bool is_negative(const dynamic &d) {
+    return (d.is_int() || d.is_long()) && d.as_long() < 0;
+}
+
+static int compare_numbers(const dynamic &a, const dynamic &b) {
+    if (a.is_double() || b.is_double()) {
+        const double x = a.as_double();
+        const double y = b.as_double();
+        if (std::isnan(x) || std::isnan(y))
+            return UNORDERED;
+        return x < y ? -1 : (x > y ? 1 : 0);
+    }
+    const bool neg_a = is_negative(a);
+    const bool neg_b = is_negative(b);
+    if (neg_a != neg_b)
+        return neg_a ? -1 : 1;
+    if (neg_a) {
+        const long x = a.as_long();
+        const long y = b.as_long();
+        return x < y ? -1 : (x > y ? 1 : 0);
+    }
+    const unsigned long x = a.as_ulong();
+    const unsigned long y = b.as_ulong();
+    return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+static int compare_values(const dynamic &a, const dynamic &b) {
+    if (is_number(a) && is_number(b))
+        return compare_numbers(a, b);
+    if (a.get_type() != b.get_type())
+        return UNORDERED;
+    switch (a.get_type()) {
+        case dynamic::type::NONE:
+            return 0;
+        case dynamic::type::BOOL:
+            return static_cast<int>(a.as_bool()) - static_cast<int>(b.as_bool());
+        case dynamic::type::STRING: {
+            const int c = a.as_string().compare(b.as_string());
+            return c < 0 ? -1 : (c > 0 ? 1 : 0);
+        }
+        default:
+            return a == b ? 0 : UNORDERED;
+    }
+}
+
+class jsonpath::parser {
+   public:
+    parser(jsonpath &path) : path(path), s(path.expression), pos(0) {
+    }
+
+    void parse() {
+        skip_ws();
+        expect('$');
+        while (true) {
+            skip_ws();
+            if (pos >= s.size())
+                break;
+
+            step st;
+            st.kind      = selector::NAME;
+            st.recursive = false;
+            st.start = st.stop = 0;
+            st.stride          = 1;
+            st.has_start = st.has_stop = false;
+            st.filter                  = 0;
+
+            if (s[pos] == '.') {
+                pos++;
+                if (peek() == '.') {
+                    pos++;
+                    st.recursive = true;
+                    if (peek() == '[') {
+                        parse_bracket(st);
+                        path.steps.push_back(st);
+                        continue;
+                    }
+                }
+                if (peek() == '*') {
+                    pos++;
+                    st.kind = selector::WILDCARD;
+                } else
+                    st.names.push_back(dynamic(parse_name()));
+            } else if (s[pos] == '[')
+                parse_bracket(st);
+            else
+                fail("unexpected character");
+            path.steps.push_back(st);
+        }
+    }
+
+   private:
+    jsonpath &         path;
+    const std::string &s;
+    size_t             pos;
+
+    [[noreturn]] void fail(const char *what) const {
+        throw domain_error(fmt::format("jsonpath {} at {}: {}", what, pos, s));
+    }
+
+    char peek() const {
+        return pos < s.size() ? s[pos] : '\0';
+    }
+
+    void skip_ws() {
+        while (pos < s.size() && isspace(static_cast<unsigned char>(s[pos])))
+            pos++;
+    }
+
+    void expect(const char c) {
+        skip_ws();
+        if (peek() != c)
+            fail(fmt::format("expected '{}'", c).c_str());
+        pos++;
+    }
+
+    bool match(const char *token) {
+        skip_ws();
+        const size_t len = strlen(token);
+        if (s.compare(pos, len, token) != 0)
+            return false;
+        pos += len;
+        return true;
+    }
+
+    string parse_name() {
+        const size_t start = pos;
+        while (pos < s.size() && !isspace(static_cast<unsigned char>(s[pos])) &&
+               strchr(".[]()=!<>&|,'\"", s[pos]) == nullptr)
+            pos++;
+        if (pos == start)
+            fail("expected a member name");
+        return s.substr(start, pos - start);
+    }
+
+    string parse_quoted() {
+        const char quote = s[pos++];
+        string     ret;
+        while (pos < s.size() && s[pos] != quote) {
+            if (s[pos] == '\\' && pos + 1 < s.size())
+                pos++;
+            ret.push_back(s[pos++]);
+        }
+        if (pos >= s.size())
+            fail("unterminated string");
+        pos++;
+        return ret;
+    }
+
+    bool parse_long(long &out) {
+        skip_ws();
+        const char *begin = s.c_str() + pos;
+        char *      end   = nullptr;
+        const long  val   = strtol(begin, &end, 10);
+        if (end == begin)
+            return false;
+        pos += end - begin;
+        out = val;
+        return true;
+    }
+
+    void parse_bracket(step &st) {
+        expect('[');
+        skip_ws();
+        if (peek() == '?') {
+            pos++;
+            expect('(');
+            st.kind   = selector::FILTER;
+            st.filter = parse_or();
+            expect(')');
+        } else if (peek() == '*') {
+            pos++;
+            st.kind = selector::WILDCARD;
+        } else if (peek() == '\'' || peek() == '"') {
+            st.kind = selector::NAME;
+            do {
+                skip_ws();
+                if (peek() != '\'' && peek() != '"')
+                    fail("expected a quoted member name");
+                st.names.push_back(dynamic(parse_quoted()));
+            } while (match(","));
+        } else {
+            long val    = 0;
+            bool has_val = parse_long(val);
+            if (match(":")) {
+                st.kind      = selector::SLICE;
+                st.has_start = has_val;
+                st.start     = val;
+                st.has_stop  = parse_long(st.stop);
+                if (match(":") && !parse_long(st.stride))
+                    st.stride = 1;
+            } else {
+                st.kind = selector::INDEX;
+                while (has_val) {
+                    st.indices.push_back(val);
+                    has_val = match(",") && parse_long(val);
+                }
+                if (st.indices.empty())
+                    fail("expected an index");
+            }
+        }
+        expect(']');
+    }
+
+    size_t add(const op kind, const size_t lhs, const size_t rhs) {
+        expr e;
+        e.kind = kind;
+        e.lhs  = lhs;
+        e.rhs  = rhs;
+        path.exprs.push_back(e);
+        return path.exprs.size() - 1;
+    }
+
+    size_t parse_or() {
+        size_t lhs = parse_and();
+        while (match("||"))
+            lhs = add(op::OR, lhs, parse_and());
+        return lhs;
+    }
+
+    size_t parse_and() {
+        size_t lhs = parse_unary();
+        while (match("&&"))
+            lhs = add(op::AND, lhs, parse_unary());
+        return lhs;
+    }
+
+    size_t parse_unary() {
+        skip_ws();
+        if (peek() == '!' && (pos + 1 >= s.size() || s[pos + 1] != '=')) {
+            pos++;
+            return add(op::NOT, parse_unary(), 0);
+        }
+        if (peek() == '(') {
+            pos++;
+            const size_t e = parse_or();
+            expect(')');
+            return e;
+        }
+
+        expr e;
+        e.lhs = e.rhs = 0;
+        e.a           = parse_operand();
+        if (match("=="))
+            e.kind = op::EQ;
+        else if (match("!="))
+            e.kind = op::NE;
+        else if (match("<="))
+            e.kind = op::LE;
+        else if (match(">="))
+            e.kind = op::GE;
+        else if (match("<"))
+            e.kind = op::LT;
+        else if (match(">"))
+            e.kind = op::GT;
+        else {
+            if (!e.a.is_path)
+                fail("expected a comparison");
+            e.kind = op::EXISTS;
+            path.exprs.push_back(e);
+            return path.exprs.size() - 1;
+        }
+        e.b = parse_operand();
+        path.exprs.push_back(e);
+        return path.exprs.size() - 1;
+    }
+
+    operand parse_operand() {
+        skip_ws();
+        operand o;
+        o.is_path  = false;
+        o.absolute = false;
+        o.literal  = nullptr;
+
+        const char c = peek();
+        if (c == '@' || c == '$') {
+            pos++;
+            o.is_path  = true;
+            o.absolute = c == '$';
+            while (true) {
+                segment seg;
+                seg.index    = 0;
+                seg.is_index = false;
+                if (peek() == '.') {
+                    pos++;
+                    seg.key = parse_name();
+                } else if (peek() == '[') {
+                    pos++;
+                    skip_ws();
+                    if (peek() == '\'' || peek() == '"')
+                        seg.key = parse_quoted();
+                    else if (parse_long(seg.index))
+                        seg.is_index = true;
+                    else
+                        fail("expected a member name or index");
+                    expect(']');
+                } else
+                    break;
+                o.path.push_back(seg);
+            }
+        } else if (c == '\'' || c == '"')
+            o.literal = parse_quoted();
+        else if (match("true"))
+            o.literal = true;
+        else if (match("false"))
+            o.literal = false;
+        else if (match("null"))
+            o.literal = nullptr;
+        else
+            o.literal = parse_number();
+        return o;
+    }
+
+    // Accepts only the JSON number grammar, so hex, inf and nan are not literals.
+    dynamic parse_number() {
+        const size_t start = pos;
+        bool         real  = false;
+        if (peek() == '-')
+            pos++;
+        if (peek() == '0')
+            pos++;
+        else if (!digits())
+            fail("expected an operand");
+        if (peek() == '.') {
+            pos++;
+            if (!digits())
+                fail("expected a digit after '.'");
+            real = true;
+        }
+        if (peek() == 'e' || peek() == 'E') {
+            pos++;
+            if (peek() == '+' || peek() == '-')
+                pos++;
+            if (!digits())
+                fail("expected a digit in exponent");
+            real = true;
+        }
+
+        const string text = s.substr(start, pos - start);
+        const double val  = strtod(text.c_str(), nullptr);
+        if (real || val < LONG_MIN || val > LONG_MAX)
+            return val;
+        return strtol(text.c_str(), nullptr, 10);
+    }
+
+    bool digits() {
+        const size_t start = pos;
+        while (isdigit(static_cast<unsigned char>(peek())))
+            pos++;
+        return pos > start;
+    }
+};
+
+jsonpath::jsonpath(const std::string &expression) : expression(expression) {
+    parser(*this).parse();
+}
+
+jsonpath::jsonpath(const char *expression) : jsonpath(string(expression)) {
+}
+
+std::vector<dynamic *> jsonpath::evaluate(dynamic &doc) const {
+    return evaluate(doc, 1);
+}
+
+std::vector<const dynamic *> jsonpath::evaluate(const dynamic &doc) const {
+    return evaluate(doc, 1);
+}
+
+std::vector<dynamic *> jsonpath::evaluate(dynamic &doc, const size_t threads) const {
+    const vector<const dynamic *> nodes = evaluate(static_cast<const dynamic &>(doc), threads);
+    vector<dynamic *>             ret;
+    ret.reserve(nodes.size());
+    for (const dynamic *node : nodes)
+        ret.push_back(const_cast<dynamic *>(node));
+    return ret;
+}
+
+std::vector<const dynamic *> jsonpath::evaluate(const dynamic &doc, const size_t threads) const {
+    vector<const dynamic *> nodes{&doc};
+    vector<const dynamic *> next;
+    for (size_t i = 0; i < steps.size(); i++) {
+        const step &s = steps[i];
+
+        if (threads > 1 && nodes.size() == 1 && !s.recursive &&
+            (s.kind == selector::WILDCARD || s.kind == selector::FILTER) &&
+            nodes[0]->is_array() && nodes[0]->size() >= PARALLEL_THRESHOLD) {
+            const dynamic &                 array = *nodes[0];
+            const size_t                    count = array.size();
+            const size_t                    chunk = (count + threads - 1) / threads;
+            vector<vector<const dynamic *>> parts(threads);
+            thread_pool::shared().run(threads, threads, [&](const size_t t) {
+                const size_t first = t * chunk;
+                const size_t last  = min(count, first + chunk);
+                for (size_t j = first; j < last; j++) {
+                    const dynamic *item = array.lookup(j);
+                    if (s.kind == selector::WILDCARD || test(doc, s.filter, *item))
+                        parts[t].push_back(item);
+                }
+                run(doc, parts[t], i + 1, steps.size());
+            });
+
+            nodes.clear();
+            for (const auto &part : parts)
+                nodes.insert(nodes.end(), part.begin(), part.end());
+            return nodes;
+        }
+
+        next.clear();
+        for (const dynamic *node : nodes)
+            apply(doc, s, *node, next);
+        nodes.swap(next);
+    }
+    return nodes;
+}
+
+const std::string &jsonpath::str() const {
+    return expression;
+}
+
+void jsonpath::run(const dynamic &root, std::vector<const dynamic *> &nodes, const size_t first,
+                   const size_t last) const {
+    vector<const dynamic *> next;
+    for (size_t i = first; i < last; i++) {
+        next.clear();
+        for (const dynamic *node : nodes)
+            apply(root, steps[i], *node, next);
+        nodes.swap(next);
+    }
+}
+
+void jsonpath::apply(const dynamic &root, const step &s, const dynamic &node,
+                     std::vector<const dynamic *> &out) const {
+    select(root, s, node, out);
+    if (!s.recursive || !(node.is_array() || node.is_map()))
+        return;
+    for (const auto item : node)
+        apply(root, s, item.value(), out);
+}
+
+void jsonpath::select(const dynamic &root, const step &s, const dynamic &node,
+                      std::vector<const dynamic *> &out) const {
+    switch (s.kind) {
+        case selector::NAME:
+            for (const dynamic &name : s.names) {
+                const dynamic *child = node.lookup(name);
+                if (child != nullptr)
+                    out.push_back(child);
+            }
+            break;
+        case selector::INDEX:
+            if (!node.is_array())
+                break;
+            for (const long index : s.indices) {
+                const long i = index < 0 ? static_cast<long>(node.size()) + index : index;
+                if (i >= 0)
+                    if (const dynamic *child = node.lookup(static_cast<size_t>(i)))
+                        out.push_back(child);
+            }
+            break;
+        case selector::WILDCARD:
+            if (node.is_array() || node.is_map())
+                for (const auto item : node)
+                    out.push_back(&item.value());
+            break;
+        case selector::SLICE: {
+            if (!node.is_array() || s.stride == 0)
+                break;
+            const long size  = static_cast<long>(node.size());
+            auto       clamp = [size](long i, const long lo, const long hi) {
+                if (i < 0)
+                    i += size;
+                return i < lo ? lo : (i > hi ? hi : i);
+            };
+            if (s.stride > 0) {
+                const long first = s.has_start ? clamp(s.start, 0, size) : 0;
+                const long last  = s.has_stop ? clamp(s.stop, 0, size) : size;
+                for (long i = first; i < last; i += s.stride)
+                    out.push_back(node.lookup(static_cast<size_t>(i)));
+            } else {
+                const long first = s.has_start ? clamp(s.start, -1, size - 1) : size - 1;
+                const long last  = s.has_stop ? clamp(s.stop, -1, size - 1) : -1;
+                for (long i = first; i > last; i += s.stride)
+                    out.push_back(node.lookup(static_cast<size_t>(i)));
+            }
+            break;
+        }
+        case selector::FILTER:
+            if (node.is_array() || node.is_map())
+                for (const auto item : node)
+                    if (test(root, s.filter, item.value()))
+                        out.push_back(&item.value());
+            break;
+    }
+}
+
+bool jsonpath::test(const dynamic &root, const size_t e, const dynamic &node) const {
+    const expr &x = exprs[e];
+    switch (x.kind) {
+        case op::OR:
+            return test(root, x.lhs, node) || test(root, x.rhs, node);
+        case op::AND:
+            return test(root, x.lhs, node) && test(root, x.rhs, node);
+        case op::NOT:
+            return !test(root, x.lhs, node);
+        case op::EXISTS:
+            return resolve(root, x.a, node) != nullptr;
+        default:
+            break;
+    }
+
+    const dynamic *a = resolve(root, x.a, node);
+    const dynamic *b = resolve(root, x.b, node);
+    if (a == nullptr || b == nullptr)
+        return false;
+
+    const int c = compare_values(*a, *b);
+    switch (x.kind) {
+        case op::EQ:
+            return c == 0;
+        case op::NE:
+            return c != 0;
+        case op::LT:
+            return c == -1;
+        case op::LE:
+            return c == -1 || c == 0;
+        case op::GT:
+            return c == 1;
+        case op::GE:
+            return c == 1 || c == 0;
+        default:
+            return false;
+    }
+}
+
+const dynamic *jsonpath::resolve(const dynamic &root, const operand &o, const dynamic &node) const {
+    if (!o.is_path)
+        return &o.literal;
+    const dynamic *cur = o.absolute ? &root : &node;
+    for (const segment &seg : o.path) {
+        if (seg.is_index) {
+            if (!cur->is_array())
+                return nullptr;
+            const long i = seg.index < 0 ? static_cast<long>(cur->size()) + seg.index : seg.index;
+            cur          = i < 0 ? nullptr : cur->lookup(static_cast<size_t>(i));
+        } else
+            cur = cur->lookup(seg.key);
+        if (cur == nullptr)
+            return nullptr;
+    }
+    return cur;
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "dynamic.hpp"
+
+namespace njones {
+    class jsonpath {
+       public:
+        jsonpath(const std::string &expression);
+        jsonpath(const char *expression);
+
+        std::vector<dynamic *>       evaluate(dynamic &doc) const;
+        std::vector<const dynamic *> evaluate(const dynamic &doc) const;
+        std::vector<dynamic *>       evaluate(dynamic &doc, const size_t threads) const;
+        std::vector<const dynamic *> evaluate(const dynamic &doc, const size_t threads) const;
+
+        const std::string &str() const;
+
+        static const size_t PARALLEL_THRESHOLD;
+
+       private:
+        enum class selector { NAME, INDEX, WILDCARD, SLICE, FILTER };
+        enum class op { OR, AND, NOT, EQ, NE, LT, LE, GT, GE, EXISTS };
+
+        struct segment {
+            dynamic key;
+            long    index    = 0;
+            bool    is_index = false;
+        };
+
+        struct operand {
+            bool                 is_path  = false;
+            bool                 absolute = false;
+            std::vector<segment> path;
+            dynamic              literal;
+        };
+
+        struct expr {
+            op      kind = op::EXISTS;
+            size_t  lhs  = 0;
+            size_t  rhs  = 0;
+            operand a;
+            operand b;
+        };
+
+        struct step {
+            selector             kind      = selector::NAME;
+            bool                 recursive = false;
+            std::vector<dynamic> names;
+            std::vector<long>    indices;
+            long                 start     = 0;
+            long                 stop      = 0;
+            long                 stride    = 1;
+            bool                 has_start = false;
+            bool                 has_stop  = false;
+            size_t               filter    = 0;
+        };
+
+        class parser;
+
+        std::string       expression;
+        std::vector<step> steps;
+        std::vector<expr> exprs;
+
+        void run(const dynamic &root, std::vector<const dynamic *> &nodes, const size_t first,
+                 const size_t last) const;
+        void apply(const dynamic &root, const step &s, const dynamic &node,
+                   std::vector<const dynamic *> &out) const;
+        void select(const dynamic &root, const step &s, const dynamic &node,
+                    std::vector<const dynamic *> &out) const;
+        bool test(const dynamic &root, const size_t e, const dynamic &node) const;
+
+        const dynamic *resolve(const dynamic &root, const operand &o, const dynamic &node) const;
+    };
+}  // namespace njones
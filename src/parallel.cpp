@@ -0,0 +1,535 @@
+#include "parallel.hpp"
+#include "stream.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <sstream>
+#include <string>
+
+using namespace std;
+using namespace njones;
+
+static thread_local bool pool_thread = false;
+
+struct thread_pool::job {
+    struct queue {
+        mutex         lock;
+        deque<size_t> tasks;
+    };
+
+    const function<void(size_t)> *task;
+    vector<unique_ptr<queue>>     queues;
+    size_t                        workers;
+    size_t                        active;
+    atomic<bool>                  failed;
+    mutex                         error_lock;
+    exception_ptr                 error;
+
+    job(const size_t tasks, const size_t workers, const function<void(size_t)> &task)
+        : task(&task), workers(workers), active(0), failed(false) {
+        for (size_t i = 0; i < workers; i++) {
+            queues.emplace_back(new queue());
+            for (size_t t = i * tasks / workers; t < (i + 1) * tasks / workers; t++)
+                queues.back()->tasks.push_back(t);
+        }
+    }
+
+    bool next(const size_t self, size_t &out) {
+        if (failed)
+            return false;
+        {
+            queue &           own = *queues[self];
+            lock_guard<mutex> l(own.lock);
+            if (!own.tasks.empty()) {
+                out = own.tasks.back();
+                own.tasks.pop_back();
+                return true;
+            }
+        }
+        for (size_t k = 1; k < workers; k++) {
+            queue &           victim = *queues[(self + k) % workers];
+            lock_guard<mutex> l(victim.lock);
+            if (!victim.tasks.empty()) {
+                out = victim.tasks.front();
+                victim.tasks.pop_front();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void execute(const size_t self) {
+        size_t t;
+        while (next(self, t)) {
+            try {
+                (*task)(t);
+            } catch (...) {
+                lock_guard<mutex> l(error_lock);
+                if (!error)
+                    error = current_exception();
+                failed = true;
+            }
+        }
+    }
+};
+
+thread_pool::thread_pool(const size_t threads) : current(nullptr), generation(0), stopping(false) {
+    for (size_t i = 0; i < threads; i++)
+        this->threads.emplace_back(&thread_pool::work, this, i + 1);
+}
+
+thread_pool::~thread_pool() {
+    {
+        lock_guard<mutex> l(lock);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (thread &t : threads)
+        t.join();
+}
+
+size_t thread_pool::size() const {
+    return threads.size();
+}
+
+void thread_pool::run(const size_t tasks, const size_t workers,
+                      const std::function<void(size_t)> &task) {
+    const size_t count = min(min(workers, threads.size() + 1), tasks);
+    if (count <= 1 || pool_thread) {
+        for (size_t t = 0; t < tasks; t++)
+            task(t);
+        return;
+    }
+
+    lock_guard<mutex> serial(run_lock);
+    job               j(tasks, count, task);
+    {
+        lock_guard<mutex> l(lock);
+        current = &j;
+        generation++;
+    }
+    wake.notify_all();
+
+    const bool nested = pool_thread;
+    pool_thread       = true;
+    j.execute(0);
+    pool_thread = nested;
+
+    {
+        unique_lock<mutex> l(lock);
+        current = nullptr;
+        done.wait(l, [&j] { return j.active == 0; });
+    }
+
+    if (j.error)
+        rethrow_exception(j.error);
+}
+
+thread_pool &thread_pool::shared() {
+    static thread_pool pool(max(thread::hardware_concurrency(), 1u) - 1);
+    return pool;
+}
+
+void thread_pool::work(const size_t id) {
+    pool_thread = true;
+
+    uint64_t           seen = 0;
+    unique_lock<mutex> l(lock);
+    while (true) {
+        wake.wait(l, [this, seen] {
+            return stopping || (current != nullptr && generation != seen);
+        });
+        if (stopping)
+            return;
+        seen   = generation;
+        job *j = current;
+        if (id >= j->workers)
+            continue;
+
+        j->active++;
+        l.unlock();
+        j->execute(id);
+        l.lock();
+        if (--j->active == 0)
+            done.notify_all();
+    }
+}
+
+void parallel::for_each(dynamic &array, const std::function<void(dynamic &)> &fn,
+                        const parallel_options &options) {
+    dynamic *items = array.data();
+    run(array.size(), options, [items, &fn](size_t, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++)
+            fn(items[i]);
+    });
+}
+
+dynamic parallel::transform(const dynamic &array,
+                            const std::function<dynamic(const dynamic &)> &fn,
+                            const parallel_options &options) {
+    const dynamic *         items = array.data();
+    const size_t            grain = max(options.grain, static_cast<size_t>(1));
+    vector<vector<dynamic>> chunks((array.size() + grain - 1) / grain);
+    run(array.size(), options, [items, &fn, &chunks](size_t chunk, size_t begin, size_t end) {
+        chunks[chunk].reserve(end - begin);
+        for (size_t i = begin; i < end; i++)
+            chunks[chunk].push_back(fn(items[i]));
+    });
+
+    dynamic ret(dynamic::type::ARRAY);
+    ret.reserve(array.size());
+    for (const vector<dynamic> &chunk : chunks)
+        for (const dynamic &d : chunk)
+            ret.push_back(d);
+    return ret;
+}
+
+dynamic parallel::filter(const dynamic &array, const std::function<bool(const dynamic &)> &pred,
+                         const parallel_options &options) {
+    const dynamic *        items = array.data();
+    const size_t           grain = max(options.grain, static_cast<size_t>(1));
+    vector<vector<size_t>> chunks((array.size() + grain - 1) / grain);
+    run(array.size(), options, [items, &pred, &chunks](size_t chunk, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++)
+            if (pred(items[i]))
+                chunks[chunk].push_back(i);
+    });
+
+    size_t count = 0;
+    for (const vector<size_t> &chunk : chunks)
+        count += chunk.size();
+
+    dynamic ret(dynamic::type::ARRAY);
+    ret.reserve(count);
+    for (const vector<size_t> &chunk : chunks)
+        for (const size_t i : chunk)
+            ret.push_back(items[i]);
+    return ret;
+}
+
+dynamic parallel::reduce(const dynamic &array, const dynamic &init,
+                         const std::function<dynamic(const dynamic &, const dynamic &)> &fn,
+                         const parallel_options &options) {
+    const dynamic * items = array.data();
+    const size_t    grain = max(options.grain, static_cast<size_t>(1));
+    vector<dynamic> partials((array.size() + grain - 1) / grain);
+    run(array.size(), options, [items, &fn, &partials](size_t chunk, size_t begin, size_t end) {
+        dynamic acc = items[begin];
+        for (size_t i = begin + 1; i < end; i++)
+            acc = fn(acc, items[i]);
+        partials[chunk] = acc;
+    });
+
+    dynamic ret = init;
+    for (const dynamic &partial : partials)
+        ret = fn(ret, partial);
+    return ret;
+}
+
+void parallel::sort(dynamic &array,
+                    const std::function<bool(const dynamic &, const dynamic &)> &less,
+                    const parallel_options &options) {
+    const size_t size  = array.size();
+    dynamic *    items = array.data();
+
+    vector<dynamic *> order(size);
+    for (size_t i = 0; i < size; i++)
+        order[i] = &items[i];
+
+    auto compare = [&less](const dynamic *a, const dynamic *b) { return less(*a, *b); };
+
+    const size_t grain  = max(options.grain, static_cast<size_t>(1));
+    const size_t blocks = max(min(workers(options), size / grain), static_cast<size_t>(1));
+
+    vector<size_t> bounds;
+    for (size_t b = 0; b <= blocks; b++)
+        bounds.push_back(b * size / blocks);
+
+    thread_pool::shared().run(blocks, workers(options), [&](size_t b) {
+        std::sort(order.begin() + bounds[b], order.begin() + bounds[b + 1], compare);
+    });
+
+    vector<dynamic *> buffer(size);
+    while (bounds.size() > 2) {
+        const size_t runs  = bounds.size() - 1;
+        const size_t pairs = (runs + 1) / 2;
+        thread_pool::shared().run(pairs, workers(options), [&](size_t p) {
+            const size_t begin = bounds[2 * p];
+            const size_t mid   = bounds[min(2 * p + 1, runs)];
+            const size_t end   = bounds[min(2 * p + 2, runs)];
+            std::merge(order.begin() + begin, order.begin() + mid, order.begin() + mid,
+                       order.begin() + end, buffer.begin() + begin, compare);
+        });
+
+        vector<size_t> merged;
+        for (size_t p = 0; p < pairs; p++)
+            merged.push_back(bounds[2 * p]);
+        merged.push_back(size);
+        order.swap(buffer);
+        bounds.swap(merged);
+    }
+
+    vector<dynamic> sorted;
+    sorted.reserve(size);
+    for (dynamic *d : order)
+        sorted.push_back(*d);
+    for (size_t i = 0; i < size; i++)
+        items[i] = move(sorted[i]);
+}
+
+size_t parallel::workers(const parallel_options &options) {
+    const size_t available = thread_pool::shared().size() + 1;
+    return options.threads == 0 ? available : min(options.threads, available);
+}
+
+void parallel::run(const size_t size, const parallel_options &options,
+                   const std::function<void(size_t, size_t, size_t)> &fn) {
+    const size_t grain  = max(options.grain, static_cast<size_t>(1));
+    const size_t chunks = (size + grain - 1) / grain;
+    thread_pool::shared().run(chunks, workers(options), [size, grain, &fn](size_t chunk) {
+        fn(chunk, chunk * grain, min((chunk + 1) * grain, size));
+    });
+}
+
+struct parallel::fragment {
+    string                                 text;
+    const dynamic *                        node   = nullptr;
+    size_t                                 begin  = 0;
+    size_t                                 end    = 0;
+    vector<pair<dynamic, const dynamic *>> entries;
+    size_t                                 indent = 0;
+    size_t                                 trim   = 0;
+    bool                                   whole  = false;
+};
+
+static size_t weight(const dynamic &d, const size_t limit) {
+    if (!d.is_array() && !d.is_map())
+        return 1;
+    if (d.is_packed())
+        return 1 + d.size();
+
+    size_t ret = 1;
+    if (d.is_array()) {
+        const dynamic *items = d.data();
+        for (size_t i = 0; i < d.size() && ret <= limit; i++)
+            ret += weight(items[i], limit - ret);
+    } else
+        for (auto iter = d.begin(); iter != d.end() && ret <= limit; ++iter)
+            ret += weight((*iter).value(), limit - ret);
+    return ret;
+}
+
+static string indentation(const size_t indent) {
+    return string(indent * 4, ' ');
+}
+
+string parallel::str(const dynamic &d, const bool pretty, const parallel_options &options) {
+    vector<fragment> parts = fragments(d, pretty, options);
+    size_t           total = 0;
+    for (const fragment &f : parts)
+        total += f.text.size();
+
+    string ret;
+    ret.reserve(total + 1);
+    for (const fragment &f : parts)
+        ret += f.text;
+    return ret + tail(d, pretty);
+}
+
+void parallel::write(const dynamic &d, std::ostream &s, const bool pretty,
+                     const parallel_options &options) {
+    callback_sink  sink([&s](const char *data, const size_t size) { s.write(data, size); });
+    dynamic_stream out(sink);
+    write(d, out, pretty, options);
+    out.flush();
+}
+
+void parallel::write(const dynamic &d, dynamic_stream &out, const bool pretty,
+                     const parallel_options &options) {
+    vector<fragment> parts;
+    plan(d, 0, pretty, max(options.grain, static_cast<size_t>(1)), parts);
+
+    vector<size_t> tasks;
+    vector<bool>   ready(parts.size(), true);
+    for (size_t i = 0; i < parts.size(); i++)
+        if (parts[i].node != nullptr) {
+            tasks.push_back(i);
+            ready[i] = false;
+        }
+
+    // Whichever thread finishes a fragment writes out every completed fragment that follows the
+    // last one written, unless another thread is already doing so and will pick it up.
+    mutex  lock;
+    size_t next    = 0;
+    bool   writing = false;
+    auto   drain   = [&parts, &ready, &next, &writing, &out](unique_lock<mutex> &l) {
+        if (writing)
+            return;
+        writing = true;
+        while (next < parts.size() && ready[next]) {
+            fragment &f = parts[next++];
+            l.unlock();
+            out.write(f.text.data(), f.text.size() - f.trim);
+            string().swap(f.text);
+            l.lock();
+        }
+        writing = false;
+    };
+
+    {
+        unique_lock<mutex> l(lock);
+        drain(l);
+    }
+    thread_pool::shared().run(tasks.size(), workers(options), [&](size_t t) {
+        render(parts[tasks[t]], pretty);
+        unique_lock<mutex> l(lock);
+        ready[tasks[t]] = true;
+        drain(l);
+    });
+
+    const string end = tail(d, pretty);
+    out.write(end.data(), end.size());
+}
+
+vector<parallel::fragment> parallel::fragments(const dynamic &d, const bool pretty,
+                                               const parallel_options &options) {
+    vector<fragment> ret;
+    plan(d, 0, pretty, max(options.grain, static_cast<size_t>(1)), ret);
+
+    vector<size_t> tasks;
+    for (size_t i = 0; i < ret.size(); i++)
+        if (ret[i].node != nullptr)
+            tasks.push_back(i);
+    thread_pool::shared().run(tasks.size(), workers(options), [&ret, &tasks, pretty](size_t t) {
+        render(ret[tasks[t]], pretty);
+    });
+
+    for (fragment &f : ret)
+        f.text.resize(f.text.size() - f.trim);
+    return ret;
+}
+
+void parallel::plan(const dynamic &d, const size_t indent, const bool pretty, const size_t grain,
+                    vector<fragment> &out) {
+    if ((!d.is_array() && !d.is_map()) || d.empty() || weight(d, grain) <= grain) {
+        out.emplace_back();
+        out.back().node   = &d;
+        out.back().indent = indent;
+        out.back().whole  = true;
+        return;
+    }
+
+    auto text = [&out](const string &s) {
+        out.emplace_back();
+        out.back().text = s;
+    };
+
+    if (d.is_array()) {
+        auto flush = [&out, &d, indent](const size_t begin, const size_t end) {
+            if (begin == end)
+                return;
+            out.emplace_back();
+            out.back().node   = &d;
+            out.back().begin  = begin;
+            out.back().end    = end;
+            out.back().indent = indent;
+        };
+
+        text("[");
+        if (d.is_packed())
+            for (size_t begin = 0; begin < d.size(); begin += grain)
+                flush(begin, std::min(begin + grain, d.size()));
+        else {
+            const dynamic *items = d.data();
+            size_t         begin = 0;
+            size_t         acc   = 0;
+            for (size_t i = 0; i < d.size(); i++) {
+                const size_t w = weight(items[i], grain);
+                if (w > grain) {
+                    flush(begin, i);
+                    plan(items[i], indent, pretty, grain, out);
+                    text(", ");
+                    begin = i + 1;
+                    acc   = 0;
+                } else if (acc + w > grain) {
+                    flush(begin, i);
+                    begin = i;
+                    acc   = w;
+                } else
+                    acc += w;
+            }
+            flush(begin, d.size());
+        }
+        out.back().trim = 2;
+        text("]");
+        return;
+    }
+
+    vector<pair<dynamic, const dynamic *>> entries;
+    size_t                                 acc = 0;
+    auto flush = [&out, &d, &entries, indent]() {
+        if (entries.empty())
+            return;
+        out.emplace_back();
+        out.back().node   = &d;
+        out.back().indent = indent;
+        out.back().entries.swap(entries);
+    };
+
+    text(pretty ? "{\n" : "{");
+    for (const auto item : d) {
+        const size_t w = weight(item.value(), grain);
+        if (w > grain) {
+            flush();
+            ostringstream key;
+            if (pretty)
+                key << indentation(indent + 1);
+            item.key().to_string(pretty, key, indent);
+            key << ": ";
+            text(key.str());
+            plan(item.value(), indent + 1, pretty, grain, out);
+            text(pretty ? ", \n" : ", ");
+            acc = 0;
+            continue;
+        }
+        if (acc + w > grain) {
+            flush();
+            acc = 0;
+        }
+        entries.emplace_back(item.key(), &item.value());
+        acc += w;
+    }
+    flush();
+    out.back().trim = pretty ? 3 : 2;
+    text(pretty ? "\n" + indentation(indent) + "}" : "}");
+}
+
+void parallel::render(fragment &f, const bool pretty) {
+    ostringstream s;
+    if (f.whole)
+        f.node->to_string(pretty, s, f.indent);
+    else if (f.node->is_array())
+        f.node->elements_to_string(pretty, s, f.indent, f.begin, f.end);
+    else
+        for (const auto &entry : f.entries) {
+            if (pretty)
+                s << indentation(f.indent + 1);
+            entry.first.to_string(pretty, s, f.indent);
+            s << ": ";
+            entry.second->to_string(pretty, s, f.indent + 1);
+            s << ", ";
+            if (pretty)
+                s << '\n';
+        }
+    f.text = s.str();
+    f.text.resize(static_cast<size_t>(s.tellp()));
+}
+
+string parallel::tail(const dynamic &d, const bool pretty) {
+    if ((!d.is_array() && !d.is_map()) || d.empty())
+        return "";
+    return pretty && d.is_map() ? "\n" : " ";
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "dynamic.hpp"
+
+namespace njones {
+    class thread_pool {
+       public:
+        thread_pool(const size_t threads);
+        ~thread_pool();
+
+        size_t size() const;
+
+        void run(const size_t tasks, const size_t workers, const std::function<void(size_t)> &task);
+
+        static thread_pool &shared();
+
+       private:
+        struct job;
+
+        std::vector<std::thread> threads;
+        std::mutex               lock;
+        std::mutex               run_lock;
+        std::condition_variable  wake;
+        std::condition_variable  done;
+        job *                    current;
+        uint64_t                 generation;
+        bool                     stopping;
+
+        void work(const size_t id);
+    };
+
+    struct parallel_options {
+        size_t grain   = 4096;
+        size_t threads = 0;
+    };
+
+    class parallel {
+       public:
+        static void for_each(dynamic &array, const std::function<void(dynamic &)> &fn,
+                             const parallel_options &options = parallel_options());
+
+        static dynamic transform(const dynamic &array,
+                                 const std::function<dynamic(const dynamic &)> &fn,
+                                 const parallel_options &options = parallel_options());
+
+        static dynamic filter(const dynamic &array,
+                              const std::function<bool(const dynamic &)> &pred,
+                              const parallel_options &options = parallel_options());
+
+        static dynamic reduce(const dynamic &array, const dynamic &init,
+                              const std::function<dynamic(const dynamic &, const dynamic &)> &fn,
+                              const parallel_options &options = parallel_options());
+
+        static void sort(dynamic &array,
+                         const std::function<bool(const dynamic &, const dynamic &)> &less,
+                         const parallel_options &options = parallel_options());
+
+        static std::string str(const dynamic &d, const bool pretty = false,
+                               const parallel_options &options = parallel_options());
+        static void        write(const dynamic &d, std::ostream &s, const bool pretty = false,
+                                 const parallel_options &options = parallel_options());
+        static void        write(const dynamic &d, dynamic_stream &out, const bool pretty = false,
+                                 const parallel_options &options = parallel_options());
+
+       private:
+        struct fragment;
+
+        static size_t workers(const parallel_options &options);
+
+        static std::vector<fragment> fragments(const dynamic &d, const bool pretty,
+                                               const parallel_options &options);
+        static void plan(const dynamic &d, const size_t indent, const bool pretty,
+                         const size_t grain, std::vector<fragment> &out);
+        static void render(fragment &f, const bool pretty);
+        static std::string tail(const dynamic &d, const bool pretty);
+
+        static void run(const size_t size, const parallel_options &options,
+                        const std::function<void(size_t, size_t, size_t)> &fn);
+    };
+}  // namespace njones
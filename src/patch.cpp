@@ -0,0 +1,233 @@
+#include "dynamic.hpp"
+
+#define FMT_HEADER_ONLY
+
+#include <fmt/format.h>
+#include <cmath>
+#include <stdexcept>
+
+#include "pointer.hpp"
+
+using namespace std;
+using namespace njones;
+
+static dynamic make_operation(const char *op, const string &path) {
+    dynamic ret;
+    ret["op"]   = op;
+    ret["path"] = path;
+    return ret;
+}
+
+static string key_token(const dynamic &key) {
+    return dynamic::pointer::escape(key.as_string());
+}
+
+static bool has_null(const dynamic &d) {
+    if (!d.is_map())
+        return false;
+    for (const auto item : d)
+        if (item.value().is_null() || has_null(item.value()))
+            return true;
+    return false;
+}
+
+dynamic dynamic::diff(const dynamic &from, const dynamic &to) {
+    dynamic patch(type::ARRAY);
+    diff(from, to, "", patch);
+    return patch;
+}
+
+void dynamic::diff(const dynamic &from, const dynamic &to, const std::string &path,
+                   dynamic &patch) {
+    if (from.v == to.v)
+        return;
+
+    if (from.get_type() != to.get_type()) {
+        dynamic op  = make_operation("replace", path);
+        op["value"] = to.deep_copy();
+        patch.push_back(op);
+        return;
+    }
+
+    if (from.is_map()) {
+        for (const auto item : from) {
+            const string   child = path + "/" + key_token(item.key());
+            const dynamic *other = to.lookup(item.key());
+            if (other == nullptr)
+                patch.push_back(make_operation("remove", child));
+            else
+                diff(item.value(), *other, child, patch);
+        }
+        for (const auto item : to) {
+            if (from.lookup(item.key()) != nullptr)
+                continue;
+            dynamic op  = make_operation("add", path + "/" + key_token(item.key()));
+            op["value"] = item.value().deep_copy();
+            patch.push_back(op);
+        }
+        return;
+    }
+
+    if (from.is_array()) {
+        const size_t from_size = from.size();
+        const size_t to_size   = to.size();
+
+        size_t prefix = 0;
+        while (prefix < from_size && prefix < to_size &&
+               identical(*from.lookup(prefix), *to.lookup(prefix)))
+            prefix++;
+
+        size_t suffix = 0;
+        while (suffix < from_size - prefix && suffix < to_size - prefix &&
+               identical(*from.lookup(from_size - suffix - 1), *to.lookup(to_size - suffix - 1)))
+            suffix++;
+
+        const size_t from_end = from_size - suffix;
+        const size_t to_end   = to_size - suffix;
+        size_t       i        = prefix;
+        for (; i < from_end && i < to_end; i++)
+            diff(*from.lookup(i), *to.lookup(i), fmt::format("{}/{}", path, i), patch);
+        for (size_t j = i; j < to_end; j++) {
+            dynamic op  = make_operation("add", fmt::format("{}/{}", path, j));
+            op["value"] = to.lookup(j)->deep_copy();
+            patch.push_back(op);
+        }
+        for (size_t j = from_end; j > i; j--)
+            patch.push_back(make_operation("remove", fmt::format("{}/{}", path, j - 1)));
+        return;
+    }
+
+    if (!identical(from, to)) {
+        dynamic op  = make_operation("replace", path);
+        op["value"] = to.deep_copy();
+        patch.push_back(op);
+    }
+}
+
+bool dynamic::identical(const dynamic &a, const dynamic &b) {
+    if (a.v == b.v)
+        return true;
+    if (a.get_type() != b.get_type())
+        return false;
+
+    switch (a.get_type()) {
+        case type::NONE:
+            return true;
+        case type::INT:
+            return a.as_int() == b.as_int();
+        case type::UINT:
+            return a.as_uint() == b.as_uint();
+        case type::LONG:
+            return a.as_long() == b.as_long();
+        case type::ULONG:
+            return a.as_ulong() == b.as_ulong();
+        case type::DOUBLE:
+            return a.as_double() == b.as_double() ||
+                   (std::isnan(a.as_double()) && std::isnan(b.as_double()));
+        case type::BOOL:
+            return a.as_bool() == b.as_bool();
+        case type::STRING:
+            return a == b;
+        case type::ARRAY:
+            if (a.size() != b.size())
+                return false;
+            for (size_t i = 0; i < a.size(); i++)
+                if (!identical(*a.lookup(i), *b.lookup(i)))
+                    return false;
+            return true;
+        case type::MAP:
+            if (a.size() != b.size())
+                return false;
+            for (const auto item : a) {
+                const dynamic *other = b.lookup(item.key());
+                if (other == nullptr || !identical(item.value(), *other))
+                    return false;
+            }
+            return true;
+    }
+    return false;
+}
+
+void dynamic::apply_patch(const dynamic &patch) {
+    patch.type_check(type::ARRAY);
+
+    auto add = [this](const pointer &path, const dynamic &val) {
+        if (!path.empty()) {
+            dynamic &parent = path.parent().get(*this);
+            if (parent.is_array()) {
+                const string &token = path.back();
+                if (token == "-")
+                    parent.push_back(val);
+                else if (token.empty() || token.find_first_not_of("0123456789") != string::npos ||
+                         (token.size() > 1 && token[0] == '0'))
+                    throw domain_error(
+                        fmt::format("dynamic patch has an invalid index: {}", path.str()));
+                else
+                    parent.insert_index(stoul(token), val);
+                return;
+            }
+        }
+        path.set(*this, val);
+    };
+
+    for (const auto item : patch) {
+        const dynamic &operation = item.value();
+        const string   op        = operation.at("op").as_string();
+        const pointer  path(operation.at("path").as_string());
+
+        if (op == "add") {
+            add(path, operation.at("value").deep_copy());
+        } else if (op == "remove") {
+            path.erase(*this);
+        } else if (op == "replace") {
+            path.get(*this) = operation.at("value").deep_copy();
+        } else if (op == "move") {
+            const pointer from(operation.at("from").as_string());
+            if (path.str().compare(0, from.str().size() + 1, from.str() + "/") == 0)
+                throw domain_error(
+                    fmt::format("dynamic patch cannot move {} into itself", from.str()));
+            const dynamic val = from.get(*this);
+            from.erase(*this);
+            add(path, val);
+        } else if (op == "copy") {
+            const pointer from(operation.at("from").as_string());
+            add(path, from.get(*this).deep_copy());
+        } else if (op == "test") {
+            if (compare(path.get(*this), operation.at("value")) != 0)
+                throw domain_error(fmt::format("dynamic patch test failed: {}", path.str()));
+        } else
+            throw domain_error(fmt::format("dynamic patch has an unknown operation: {}", op));
+    }
+}
+
+void dynamic::merge_patch(dynamic &&patch) {
+    if (!patch.is_map()) {
+        *this = move(patch);
+        return;
+    }
+    if (!is_map())
+        *this = dynamic(type::MAP);
+
+    for (auto item : patch) {
+        dynamic  val    = item.value();
+        dynamic *target = lookup(item.key());
+        if (val.is_null()) {
+            if (target != nullptr)
+                erase(item.key());
+        } else if (target != nullptr && val.is_map()) {
+            target->merge_patch(move(val));
+        } else if (target != nullptr) {
+            *target = move(val);
+        } else if (has_null(val)) {
+            dynamic fresh(type::MAP);
+            fresh.merge_patch(move(val));
+            (*this)[item.key()] = move(fresh);
+        } else
+            (*this)[item.key()] = move(val);
+    }
+
+    // Nothing else holds the patch, so drop its references to the values now shared with this
+    // document instead of leaving the caller a patch that aliases them.
+    if (patch.v.use_count() == 1)
+        patch.clear();
+}
@@ -0,0 +1,260 @@
+#include "pointer.hpp"
+
+#define FMT_HEADER_ONLY
+
+#include <fmt/format.h>
+#include <algorithm>
+#include <cctype>
+#include <climits>
+#include <numeric>
+#include <stdexcept>
+
+using namespace std;
+using namespace njones;
+
+dynamic::pointer::pointer() {
+}
+
+dynamic::pointer::pointer(const std::string &path) : path(path) {
+    if (path.empty())
+        return;
+    if (path[0] != '/')
+        throw domain_error(fmt::format("dynamic pointer must begin with '/': {}", path));
+
+    size_t start = 1;
+    while (true) {
+        const size_t end = path.find('/', start);
+        string       token;
+        const size_t stop = end == string::npos ? path.size() : end;
+        token.reserve(stop - start);
+        for (size_t i = start; i < stop; i++) {
+            if (path[i] != '~') {
+                token.push_back(path[i]);
+                continue;
+            }
+            if (i + 1 < stop && path[i + 1] == '0')
+                token.push_back('~');
+            else if (i + 1 < stop && path[i + 1] == '1')
+                token.push_back('/');
+            else
+                throw domain_error(fmt::format("dynamic pointer has an invalid escape: {}", path));
+            i++;
+        }
+        segments.push_back(make_segment(token));
+        if (end == string::npos)
+            break;
+        start = end + 1;
+    }
+}
+
+dynamic::pointer::pointer(const char *path) : pointer(string(path)) {
+}
+
+const dynamic &dynamic::pointer::get(const dynamic &doc) const {
+    const dynamic *ret = find(doc);
+    if (ret == nullptr)
+        throw range_error(fmt::format("dynamic pointer does not resolve: {}", path));
+    return *ret;
+}
+
+dynamic &dynamic::pointer::get(dynamic &doc) const {
+    dynamic *ret = find(doc);
+    if (ret == nullptr)
+        throw range_error(fmt::format("dynamic pointer does not resolve: {}", path));
+    return *ret;
+}
+
+const dynamic *dynamic::pointer::find(const dynamic &doc) const {
+    const dynamic *node = &doc;
+    for (const segment &seg : segments) {
+        node = step(*node, seg);
+        if (node == nullptr)
+            return nullptr;
+    }
+    return node;
+}
+
+dynamic *dynamic::pointer::find(dynamic &doc) const {
+    dynamic *node = &doc;
+    for (const segment &seg : segments) {
+        node = step(*node, seg);
+        if (node == nullptr)
+            return nullptr;
+    }
+    return node;
+}
+
+bool dynamic::pointer::contains(const dynamic &doc) const {
+    return find(doc) != nullptr;
+}
+
+void dynamic::pointer::set(dynamic &doc, const dynamic &val) const {
+    if (segments.empty()) {
+        doc = val;
+        return;
+    }
+
+    dynamic *node = &doc;
+    for (size_t i = 0; i + 1 < segments.size(); i++) {
+        dynamic *next = step(*node, segments[i]);
+        if (next == nullptr) {
+            if (!node->is_map())
+                throw range_error(fmt::format("dynamic pointer does not resolve: {}", path));
+            next = &(*node)[segments[i].key];
+        }
+        node = next;
+    }
+
+    const segment &seg = segments.back();
+    if (node->is_map()) {
+        dynamic *target = step(*node, seg);
+        if (target != nullptr)
+            *target = val;
+        else
+            (*node)[seg.key] = val;
+    } else if (node->is_array()) {
+        if (seg.is_end || (seg.is_index && seg.index == node->size()))
+            node->push_back(val);
+        else if (seg.is_index && seg.index < node->size())
+            *(node->lookup(seg.index)) = val;
+        else
+            throw range_error(fmt::format("dynamic pointer does not resolve: {}", path));
+    } else
+        throw domain_error("dynamic value is not an array or map");
+}
+
+void dynamic::pointer::erase(dynamic &doc) const {
+    if (segments.empty())
+        throw domain_error("dynamic pointer cannot erase the document root");
+
+    dynamic *node = &doc;
+    for (size_t i = 0; i + 1 < segments.size(); i++) {
+        node = step(*node, segments[i]);
+        if (node == nullptr)
+            throw range_error(fmt::format("dynamic pointer does not resolve: {}", path));
+    }
+
+    const segment &seg = segments.back();
+    if (node->lookup(seg.key) != nullptr)
+        node->erase(seg.key);
+    else if (seg.is_index && node->lookup(seg.index_key) != nullptr)
+        node->erase(seg.index_key);
+    else if (seg.is_index && node->lookup(seg.index) != nullptr)
+        node->erase_index(seg.index);
+    else
+        throw range_error(fmt::format("dynamic pointer does not resolve: {}", path));
+}
+
+dynamic::pointer dynamic::pointer::parent() const {
+    if (segments.empty())
+        throw domain_error("dynamic pointer root has no parent");
+    return pointer(path.substr(0, path.rfind('/')));
+}
+
+dynamic::pointer dynamic::pointer::append(const std::string &token) const {
+    return pointer(path + "/" + escape(token));
+}
+
+dynamic::pointer dynamic::pointer::append(const size_t index) const {
+    return pointer(fmt::format("{}/{}", path, index));
+}
+
+const std::string &dynamic::pointer::str() const {
+    return path;
+}
+
+const std::string &dynamic::pointer::back() const {
+    if (segments.empty())
+        throw domain_error("dynamic pointer root has no tokens");
+    return segments.back().token;
+}
+
+size_t dynamic::pointer::size() const {
+    return segments.size();
+}
+
+bool dynamic::pointer::empty() const {
+    return segments.empty();
+}
+
+std::string dynamic::pointer::escape(const std::string &token) {
+    string ret;
+    ret.reserve(token.size());
+    for (const char c : token) {
+        if (c == '~')
+            ret.append("~0");
+        else if (c == '/')
+            ret.append("~1");
+        else
+            ret.push_back(c);
+    }
+    return ret;
+}
+
+void dynamic::pointer::resolve(const dynamic &doc, const std::vector<pointer> &pointers,
+                               std::vector<const dynamic *> &out) {
+    vector<size_t> order(pointers.size());
+    iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&pointers](const size_t a, const size_t b) {
+        const vector<segment> &lhs = pointers[a].segments;
+        const vector<segment> &rhs = pointers[b].segments;
+        return lexicographical_compare(
+            lhs.begin(), lhs.end(), rhs.begin(), rhs.end(),
+            [](const segment &l, const segment &r) { return l.token < r.token; });
+    });
+
+    out.assign(pointers.size(), nullptr);
+
+    vector<const dynamic *> stack{&doc};
+    const pointer *         prev = nullptr;
+    for (const size_t i : order) {
+        const pointer &p      = pointers[i];
+        size_t         common = 0;
+        if (prev != nullptr) {
+            const size_t limit = std::min(std::min(prev->size(), p.size()), stack.size() - 1);
+            while (common < limit && prev->segments[common].token == p.segments[common].token)
+                common++;
+        }
+        stack.resize(common + 1);
+
+        for (size_t k = common; k < p.size() && stack.back() != nullptr; k++)
+            stack.push_back(step(*stack.back(), p.segments[k]));
+
+        if (stack.size() == p.size() + 1)
+            out[i] = stack.back();
+        prev = &p;
+    }
+}
+
+dynamic::pointer::segment dynamic::pointer::make_segment(const std::string &token) {
+    segment seg;
+    seg.token    = token;
+    seg.key      = token;
+    seg.index    = 0;
+    seg.is_index = false;
+    seg.is_end   = token == "-";
+
+    const bool digits = !token.empty() && token.size() <= 19 &&
+                        all_of(token.begin(), token.end(), [](char c) { return isdigit(c); });
+    if (digits && (token.size() == 1 || token[0] != '0')) {
+        seg.is_index = true;
+        seg.index    = stoul(token);
+        if (seg.index <= INT_MAX)
+            seg.index_key = static_cast<int>(seg.index);
+        else
+            seg.index_key = static_cast<unsigned long>(seg.index);
+    }
+    return seg;
+}
+
+dynamic *dynamic::pointer::step(const dynamic &node, const segment &seg) {
+    if (node.is_map()) {
+        dynamic *ret = node.lookup(seg.key);
+        if (ret == nullptr && seg.is_index)
+            ret = node.lookup(seg.index_key);
+        return ret;
+    }
+    if (node.is_array() && seg.is_index)
+        return node.lookup(seg.index);
+    return nullptr;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "dynamic.hpp"
+
+namespace njones {
+    class dynamic::pointer {
+       public:
+        pointer();
+        pointer(const std::string &path);
+        pointer(const char *path);
+
+        const dynamic &get(const dynamic &doc) const;
+        dynamic &      get(dynamic &doc) const;
+        const dynamic *find(const dynamic &doc) const;
+        dynamic *      find(dynamic &doc) const;
+
+        bool contains(const dynamic &doc) const;
+
+        void set(dynamic &doc, const dynamic &val) const;
+        void erase(dynamic &doc) const;
+
+        pointer parent() const;
+        pointer append(const std::string &token) const;
+        pointer append(const size_t index) const;
+
+        const std::string &str() const;
+        const std::string &back() const;
+
+        size_t size() const;
+        bool   empty() const;
+
+        static std::string escape(const std::string &token);
+
+        static void resolve(const dynamic &doc, const std::vector<pointer> &pointers,
+                            std::vector<const dynamic *> &out);
+
+       private:
+        struct segment {
+            std::string token;
+            dynamic     key;
+            dynamic     index_key;
+            size_t      index;
+            bool        is_index;
+            bool        is_end;
+        };
+
+        std::string          path;
+        std::vector<segment> segments;
+
+        static segment make_segment(const std::string &token);
+
+        static dynamic *step(const dynamic &node, const segment &seg);
+    };
+}  // namespace njones
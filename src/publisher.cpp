@@ -0,0 +1,127 @@
+#include "publisher.hpp"
+
+#include <functional>
+#include <stdexcept>
+#include <thread>
+
+using namespace std;
+using namespace njones;
+
+dynamic_snapshot::dynamic_snapshot(dynamic_publisher *publisher, const size_t slot,
+                                   const dynamic *value, const uint64_t number)
+    : publisher(publisher), slot(slot), value(value), number(number) {
+}
+
+dynamic_snapshot::dynamic_snapshot(const shared_ptr<const dynamic> &pinned, const uint64_t number)
+    : publisher(nullptr), slot(0), value(pinned.get()), number(number), pinned(pinned) {
+}
+
+dynamic_snapshot::dynamic_snapshot(dynamic_snapshot &&other)
+    : publisher(other.publisher),
+      slot(other.slot),
+      value(other.value),
+      number(other.number),
+      pinned(move(other.pinned)) {
+    other.publisher = nullptr;
+}
+
+dynamic_snapshot::~dynamic_snapshot() {
+    if (publisher != nullptr)
+        publisher->release(slot);
+}
+
+const dynamic &dynamic_snapshot::root() const {
+    return *value;
+}
+
+const dynamic &dynamic_snapshot::operator*() const {
+    return *value;
+}
+
+const dynamic *dynamic_snapshot::operator->() const {
+    return value;
+}
+
+uint64_t dynamic_snapshot::version() const {
+    return number;
+}
+
+dynamic_publisher::dynamic_publisher(const dynamic &root, const size_t readers)
+    : current(new version{root, 1}),
+      latest(make_shared<const version>(version{root, 1})),
+      epoch(1),
+      slots(readers) {
+    if (readers == 0)
+        throw domain_error("dynamic publisher needs at least one reader slot");
+    for (reader_slot &s : slots)
+        s.epoch.store(0, memory_order_relaxed);
+}
+
+dynamic_publisher::~dynamic_publisher() {
+    for (const auto &r : retired_versions)
+        delete r.first;
+    delete current.load();
+}
+
+void dynamic_publisher::publish(const dynamic &root) {
+    lock_guard<mutex> l(write_lock);
+    version *         next = new version{root, current.load()->number + 1};
+    version *         old  = current.exchange(next);
+    atomic_store(&latest, make_shared<const version>(*next));
+    retired_versions.emplace_back(old, epoch.fetch_add(1) + 1);
+    collect();
+}
+
+dynamic_snapshot dynamic_publisher::snapshot() {
+    static thread_local const size_t hint = std::hash<thread::id>()(this_thread::get_id());
+
+    const uint64_t e = epoch.load();
+    for (size_t i = 0; i < slots.size(); i++) {
+        const size_t slot     = (hint + i) % slots.size();
+        uint64_t     expected = 0;
+        if (slots[slot].epoch.load(memory_order_relaxed) == 0 &&
+            slots[slot].epoch.compare_exchange_strong(expected, e)) {
+            const version *v = current.load();
+            return dynamic_snapshot(this, slot, &v->root, v->number);
+        }
+    }
+
+    // Every slot is taken: pin a reference-counted copy of the latest version rather than waiting
+    // for a reader to leave.
+    const shared_ptr<const version> v = atomic_load(&latest);
+    return dynamic_snapshot(shared_ptr<const dynamic>(v, &v->root), v->number);
+}
+
+size_t dynamic_publisher::reclaim() {
+    lock_guard<mutex> l(write_lock);
+    return collect();
+}
+
+size_t dynamic_publisher::retired() const {
+    lock_guard<mutex> l(write_lock);
+    return retired_versions.size();
+}
+
+void dynamic_publisher::release(const size_t slot) {
+    slots[slot].epoch.store(0, memory_order_release);
+}
+
+size_t dynamic_publisher::collect() {
+    uint64_t oldest = UINT64_MAX;
+    for (const reader_slot &s : slots) {
+        const uint64_t e = s.epoch.load();
+        if (e != 0 && e < oldest)
+            oldest = e;
+    }
+
+    size_t kept = 0;
+    for (const auto &r : retired_versions) {
+        if (r.second <= oldest)
+            delete r.first;
+        else
+            retired_versions[kept++] = r;
+    }
+    const size_t freed = retired_versions.size() - kept;
+    retired_versions.resize(kept);
+    return freed;
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "dynamic.hpp"
+
+namespace njones {
+    class dynamic_publisher;
+
+    class dynamic_snapshot {
+       public:
+        dynamic_snapshot(dynamic_snapshot &&other);
+        dynamic_snapshot(const dynamic_snapshot &other) = delete;
+        ~dynamic_snapshot();
+
+        dynamic_snapshot &operator=(const dynamic_snapshot &other) = delete;
+
+        const dynamic &root() const;
+        const dynamic &operator*() const;
+        const dynamic *operator->() const;
+
+        uint64_t version() const;
+
+       private:
+        friend class dynamic_publisher;
+
+        dynamic_publisher *            publisher;
+        size_t                         slot;
+        const dynamic *                value;
+        uint64_t                       number;
+        std::shared_ptr<const dynamic> pinned;
+
+        dynamic_snapshot(dynamic_publisher *publisher, const size_t slot, const dynamic *value,
+                         const uint64_t number);
+        dynamic_snapshot(const std::shared_ptr<const dynamic> &pinned, const uint64_t number);
+    };
+
+    class dynamic_publisher {
+       public:
+        dynamic_publisher(const dynamic &root = dynamic(), const size_t readers = 256);
+        dynamic_publisher(const dynamic_publisher &other) = delete;
+        ~dynamic_publisher();
+
+        dynamic_publisher &operator=(const dynamic_publisher &other) = delete;
+
+        void             publish(const dynamic &root);
+        dynamic_snapshot snapshot();
+
+        size_t reclaim();
+        size_t retired() const;
+
+       private:
+        friend class dynamic_snapshot;
+
+        struct version {
+            dynamic  root;
+            uint64_t number;
+        };
+
+        struct reader_slot {
+            std::atomic<uint64_t> epoch;
+            char                  padding[64 - sizeof(std::atomic<uint64_t>)];
+        };
+
+        std::atomic<version *>                      current;
+        std::shared_ptr<const version>              latest;
+        std::atomic<uint64_t>                       epoch;
+        std::vector<reader_slot>                    slots;
+        mutable std::mutex                          write_lock;
+        std::vector<std::pair<version *, uint64_t>> retired_versions;
+
+        size_t collect();
+        void   release(const size_t slot);
+    };
+}  // namespace njones
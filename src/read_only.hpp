@@ -0,0 +1,177 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include "dynamic.hpp"
+
+namespace njones {
+    // Type checks and conversions shared by the read-only document formats. Value provides
+    // get_type(), size() and c_str(), plus private members made visible to this class:
+    //
+    //     static const char *const NAME;  // used in error messages, e.g. "frozen value"
+    //     uint64_t scalar() const;        // raw payload of a number or bool
+    //     template <class F>
+    //     void items(F fn) const;         // fn(key, value) per element; keys of arrays are null
+    template <class Value>
+    class read_only_value {
+       public:
+        bool is_null() const {
+            return self().get_type() == dynamic::type::NONE;
+        }
+
+        bool is_int() const {
+            return self().get_type() == dynamic::type::INT;
+        }
+
+        bool is_uint() const {
+            return self().get_type() == dynamic::type::UINT;
+        }
+
+        bool is_long() const {
+            return self().get_type() == dynamic::type::LONG;
+        }
+
+        bool is_ulong() const {
+            return self().get_type() == dynamic::type::ULONG;
+        }
+
+        bool is_double() const {
+            return self().get_type() == dynamic::type::DOUBLE;
+        }
+
+        bool is_bool() const {
+            return self().get_type() == dynamic::type::BOOL;
+        }
+
+        bool is_string() const {
+            return self().get_type() == dynamic::type::STRING;
+        }
+
+        bool is_array() const {
+            return self().get_type() == dynamic::type::ARRAY;
+        }
+
+        bool is_map() const {
+            return self().get_type() == dynamic::type::MAP;
+        }
+
+        int as_int() const {
+            return static_cast<int>(as_long());
+        }
+
+        unsigned int as_uint() const {
+            return static_cast<unsigned int>(as_ulong());
+        }
+
+        long as_long() const {
+            switch (self().get_type()) {
+                case dynamic::type::NONE:
+                    return 0;
+                case dynamic::type::INT:
+                case dynamic::type::UINT:
+                case dynamic::type::LONG:
+                case dynamic::type::ULONG:
+                case dynamic::type::BOOL:
+                    return static_cast<long>(self().scalar());
+                case dynamic::type::DOUBLE:
+                    return static_cast<long>(as_double());
+                default:
+                    throw std::domain_error(std::string(Value::NAME) +
+                                            " is not convertible to long");
+            }
+        }
+
+        unsigned long as_ulong() const {
+            switch (self().get_type()) {
+                case dynamic::type::DOUBLE:
+                    return static_cast<unsigned long>(as_double());
+                default:
+                    return static_cast<unsigned long>(as_long());
+            }
+        }
+
+        double as_double() const {
+            switch (self().get_type()) {
+                case dynamic::type::DOUBLE: {
+                    const uint64_t bits = self().scalar();
+                    double         val;
+                    memcpy(&val, &bits, sizeof(val));
+                    return val;
+                }
+                case dynamic::type::UINT:
+                case dynamic::type::ULONG:
+                    return static_cast<double>(as_ulong());
+                default:
+                    return static_cast<double>(as_long());
+            }
+        }
+
+        bool as_bool() const {
+            switch (self().get_type()) {
+                case dynamic::type::DOUBLE:
+                    return as_double() != 0.0;
+                case dynamic::type::STRING:
+                case dynamic::type::ARRAY:
+                case dynamic::type::MAP:
+                    return !empty();
+                default:
+                    return as_long() != 0;
+            }
+        }
+
+        std::string as_string() const {
+            if (self().get_type() == dynamic::type::STRING)
+                return std::string(self().c_str(), self().size());
+            return to_dynamic().str();
+        }
+
+        bool empty() const {
+            return self().size() == 0;
+        }
+
+        dynamic to_dynamic() const {
+            switch (self().get_type()) {
+                case dynamic::type::NONE:
+                    return dynamic(nullptr);
+                case dynamic::type::INT:
+                    return dynamic(as_int());
+                case dynamic::type::UINT:
+                    return dynamic(as_uint());
+                case dynamic::type::LONG:
+                    return dynamic(as_long());
+                case dynamic::type::ULONG:
+                    return dynamic(as_ulong());
+                case dynamic::type::DOUBLE:
+                    return dynamic(as_double());
+                case dynamic::type::BOOL:
+                    return dynamic(as_bool());
+                case dynamic::type::STRING:
+                    return dynamic(as_string());
+                case dynamic::type::ARRAY: {
+                    dynamic ret(dynamic::type::ARRAY);
+                    ret.reserve(self().size());
+                    self().items([&ret](const Value &, const Value &val) {
+                        ret.push_back(val.to_dynamic());
+                    });
+                    return ret;
+                }
+                case dynamic::type::MAP: {
+                    dynamic ret(dynamic::type::MAP);
+                    self().items([&ret](const Value &key, const Value &val) {
+                        ret[key.to_dynamic()] = val.to_dynamic();
+                    });
+                    return ret;
+                }
+            }
+            throw std::domain_error(std::string(Value::NAME) + " has an invalid type");
+        }
+
+       private:
+        const Value &self() const {
+            return static_cast<const Value &>(*this);
+        }
+    };
+}  // namespace njones
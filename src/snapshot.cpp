@@ -0,0 +1,367 @@
+#include "snapshot.hpp"
+
+#define FMT_HEADER_ONLY
+
+#include <fcntl.h>
+#include <fmt/format.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <system_error>
+#include <vector>
+
+using namespace std;
+using namespace njones;
+
+static const char     SNAPSHOT_MAGIC[4] = {'N', 'J', 'D', 'S'};
+static const uint32_t SNAPSHOT_VERSION  = 1;
+static const size_t   HEADER_SIZE       = 24;
+static const size_t   NODE_SIZE         = 8;
+
+const char *const dynamic_view::NAME = "dynamic view";
+
+struct map_entry {
+    uint64_t hash;
+    uint64_t key;
+    uint64_t value;
+};
+
+static void pad(string &buf) {
+    buf.append((NODE_SIZE - buf.size() % NODE_SIZE) % NODE_SIZE, '\0');
+}
+
+static void append_u32(string &buf, const uint32_t val) {
+    buf.append(reinterpret_cast<const char *>(&val), sizeof(val));
+}
+
+static void append_u64(string &buf, const uint64_t val) {
+    buf.append(reinterpret_cast<const char *>(&val), sizeof(val));
+}
+
+static void append_node(string &buf, const dynamic::type t, const size_t size) {
+    if (size > UINT32_MAX)
+        throw length_error(fmt::format("dynamic value of size {} is too large to snapshot", size));
+    append_u32(buf, static_cast<uint32_t>(t));
+    append_u32(buf, static_cast<uint32_t>(size));
+}
+
+static uint64_t write_node(string &buf, const dynamic &d) {
+    switch (d.get_type()) {
+        case dynamic::type::ARRAY: {
+            vector<uint64_t> children;
+            children.reserve(d.size());
+            for (const auto item : d)
+                children.push_back(write_node(buf, item.value()));
+            const uint64_t offset = buf.size();
+            append_node(buf, dynamic::type::ARRAY, children.size());
+            for (const uint64_t child : children)
+                append_u64(buf, child);
+            return offset;
+        }
+        case dynamic::type::MAP: {
+            vector<map_entry> entries;
+            entries.reserve(d.size());
+            for (const auto item : d) {
+                const dynamic key = item.key();
+                const string  raw = key.is_string() ? key.as_string() : key.str();
+                map_entry     entry;
+                entry.hash  = dynamic_view::hash_key(raw.data(), raw.size());
+                entry.key   = write_node(buf, key);
+                entry.value = write_node(buf, item.value());
+                entries.push_back(entry);
+            }
+            sort(entries.begin(), entries.end(),
+                 [](const map_entry &a, const map_entry &b) { return a.hash < b.hash; });
+            const uint64_t offset = buf.size();
+            append_node(buf, dynamic::type::MAP, entries.size());
+            for (const map_entry &entry : entries) {
+                append_u64(buf, entry.hash);
+                append_u64(buf, entry.key);
+                append_u64(buf, entry.value);
+            }
+            return offset;
+        }
+        case dynamic::type::STRING: {
+            const string   val    = d.as_string();
+            const uint64_t offset = buf.size();
+            append_node(buf, dynamic::type::STRING, val.size());
+            buf.append(val);
+            buf.push_back('\0');
+            pad(buf);
+            return offset;
+        }
+        default: {
+            const uint64_t offset = buf.size();
+            append_node(buf, d.get_type(), 0);
+            switch (d.get_type()) {
+                case dynamic::type::INT:
+                case dynamic::type::LONG:
+                    append_u64(buf, static_cast<uint64_t>(d.as_long()));
+                    break;
+                case dynamic::type::UINT:
+                case dynamic::type::ULONG:
+                    append_u64(buf, d.as_ulong());
+                    break;
+                case dynamic::type::DOUBLE: {
+                    const double val = d.as_double();
+                    uint64_t     bits;
+                    memcpy(&bits, &val, sizeof(bits));
+                    append_u64(buf, bits);
+                    break;
+                }
+                case dynamic::type::BOOL:
+                    append_u64(buf, d.as_bool() ? 1 : 0);
+                    break;
+                default:
+                    break;
+            }
+            return offset;
+        }
+    }
+}
+
+void dynamic::save_snapshot(std::ostream &s) const {
+    const string buf = save_snapshot();
+    s.write(buf.data(), buf.size());
+}
+
+string dynamic::save_snapshot() const {
+    string buf(HEADER_SIZE, '\0');
+    const uint64_t root   = write_node(buf, *this);
+    const uint64_t length = buf.size();
+    memcpy(&buf[0], SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+    memcpy(&buf[4], &SNAPSHOT_VERSION, sizeof(SNAPSHOT_VERSION));
+    memcpy(&buf[8], &root, sizeof(root));
+    memcpy(&buf[16], &length, sizeof(length));
+    return buf;
+}
+
+dynamic_view::dynamic_view() : base(nullptr), length(0), offset(0) {
+}
+
+dynamic_view::dynamic_view(const void *data, const size_t size)
+    : base(static_cast<const char *>(data)), length(size) {
+    uint32_t version;
+    uint64_t total;
+    if (size < HEADER_SIZE || memcmp(base, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0)
+        throw domain_error("dynamic snapshot has an invalid header");
+    memcpy(&version, base + 4, sizeof(version));
+    memcpy(&offset, base + 8, sizeof(offset));
+    memcpy(&total, base + 16, sizeof(total));
+    if (version != SNAPSHOT_VERSION)
+        throw domain_error(fmt::format("dynamic snapshot version {} is not supported", version));
+    if (total > size)
+        throw range_error(fmt::format("dynamic snapshot is truncated {} < {}", size, total));
+    header_type();
+}
+
+dynamic_view::dynamic_view(const char *base, const size_t length, const uint64_t offset)
+    : base(base), length(length), offset(offset) {
+}
+
+dynamic_view::dynamic_view(const dynamic_view &other)
+    : base(other.base), length(other.length), offset(other.offset) {
+}
+
+dynamic_view::~dynamic_view() {
+}
+
+dynamic_view &dynamic_view::operator=(const dynamic_view &other) {
+    base   = other.base;
+    length = other.length;
+    offset = other.offset;
+
+    return *this;
+}
+
+dynamic::type dynamic_view::get_type() const {
+    if (base == nullptr)
+        return dynamic::type::NONE;
+    return static_cast<dynamic::type>(header_type());
+}
+
+const char *dynamic_view::c_str() const {
+    type_check(dynamic::type::STRING);
+    const uint64_t len = header_size();
+    if (offset + NODE_SIZE + len >= length)
+        throw range_error("dynamic snapshot string is out of bounds");
+    return base + offset + NODE_SIZE;
+}
+
+dynamic_view dynamic_view::operator[](const size_t index) const {
+    type_check(dynamic::type::ARRAY);
+    if (index >= header_size())
+        throw range_error(
+            fmt::format("dynamic view index out of range {} > {}", index, size() - 1));
+    return dynamic_view(base, length, word(index));
+}
+
+dynamic_view dynamic_view::operator[](const std::string &key) const {
+    dynamic_view ret;
+    if (!find(key.data(), key.size(), ret))
+        throw range_error(fmt::format("dynamic view has no member: {}", key));
+    return ret;
+}
+
+dynamic_view dynamic_view::at(const size_t index) const {
+    return (*this)[index];
+}
+
+dynamic_view dynamic_view::at(const std::string &key) const {
+    return (*this)[key];
+}
+
+dynamic_view dynamic_view::at(const char *key, const size_t size) const {
+    dynamic_view ret;
+    if (!find(key, size, ret))
+        throw range_error(fmt::format("dynamic view has no member: {}", string(key, size)));
+    return ret;
+}
+
+bool dynamic_view::has(const std::string &key) const {
+    dynamic_view ret;
+    return find(key.data(), key.size(), ret);
+}
+
+bool dynamic_view::has(const char *key, const size_t size) const {
+    dynamic_view ret;
+    return find(key, size, ret);
+}
+
+dynamic_view dynamic_view::key(const size_t index) const {
+    type_check(dynamic::type::MAP);
+    if (index >= header_size())
+        throw range_error(
+            fmt::format("dynamic view index out of range {} > {}", index, size() - 1));
+    return dynamic_view(base, length, word(index * 3 + 1));
+}
+
+dynamic_view dynamic_view::value(const size_t index) const {
+    type_check(dynamic::type::MAP);
+    if (index >= header_size())
+        throw range_error(
+            fmt::format("dynamic view index out of range {} > {}", index, size() - 1));
+    return dynamic_view(base, length, word(index * 3 + 2));
+}
+
+size_t dynamic_view::size() const {
+    switch (get_type()) {
+        case dynamic::type::STRING:
+        case dynamic::type::ARRAY:
+        case dynamic::type::MAP:
+            return header_size();
+        default:
+            throw domain_error("dynamic view type must be string, array, or map to have a size");
+    }
+}
+
+uint64_t dynamic_view::hash_key(const char *data, const size_t size) {
+    uint64_t hash = 14695981039346656037UL;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= static_cast<unsigned char>(data[i]);
+        hash *= 1099511628211UL;
+    }
+    return hash;
+}
+
+uint64_t dynamic_view::scalar() const {
+    return word(0);
+}
+
+uint32_t dynamic_view::header_type() const {
+    if (offset % NODE_SIZE != 0 || offset < HEADER_SIZE || offset + NODE_SIZE > length)
+        throw range_error(fmt::format("dynamic snapshot offset {} is out of bounds", offset));
+    uint32_t t;
+    memcpy(&t, base + offset, sizeof(t));
+    if (t > static_cast<uint32_t>(dynamic::type::MAP))
+        throw domain_error(fmt::format("dynamic snapshot type {} is invalid", t));
+    return t;
+}
+
+uint32_t dynamic_view::header_size() const {
+    uint32_t s;
+    memcpy(&s, base + offset + sizeof(uint32_t), sizeof(s));
+    return s;
+}
+
+uint64_t dynamic_view::word(const uint64_t index) const {
+    const uint64_t pos = offset + NODE_SIZE + index * sizeof(uint64_t);
+    if (pos + sizeof(uint64_t) > length)
+        throw range_error(fmt::format("dynamic snapshot offset {} is out of bounds", pos));
+    uint64_t val;
+    memcpy(&val, base + pos, sizeof(val));
+    return val;
+}
+
+void dynamic_view::type_check(const dynamic::type t) const {
+    if (get_type() != t)
+        throw domain_error("dynamic view has the wrong type for this operation");
+}
+
+bool dynamic_view::find(const char *key, const size_t size, dynamic_view &out) const {
+    type_check(dynamic::type::MAP);
+    const uint64_t hash  = hash_key(key, size);
+    size_t         first = 0;
+    size_t         last  = header_size();
+    while (first < last) {
+        const size_t mid = first + (last - first) / 2;
+        if (word(mid * 3) < hash)
+            first = mid + 1;
+        else
+            last = mid;
+    }
+    for (; first < header_size() && word(first * 3) == hash; first++) {
+        const dynamic_view k(base, length, word(first * 3 + 1));
+        if (k.is_string() && k.header_size() == size && memcmp(k.c_str(), key, size) == 0) {
+            out = dynamic_view(base, length, word(first * 3 + 2));
+            return true;
+        }
+    }
+    return false;
+}
+
+mapped_snapshot::mapped_snapshot(const std::string &path) : addr(nullptr), length(0) {
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        throw system_error(errno, generic_category(), fmt::format("unable to open {}", path));
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        const int err = errno;
+        close(fd);
+        throw system_error(err, generic_category(), fmt::format("unable to stat {}", path));
+    }
+
+    length = static_cast<size_t>(st.st_size);
+    addr          = mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+    const int err = errno;
+    close(fd);
+    if (addr == MAP_FAILED) {
+        addr = nullptr;
+        throw system_error(err, generic_category(), fmt::format("unable to map {}", path));
+    }
+
+    try {
+        root();
+    } catch (...) {
+        munmap(addr, length);
+        throw;
+    }
+}
+
+mapped_snapshot::~mapped_snapshot() {
+    if (addr != nullptr)
+        munmap(addr, length);
+}
+
+dynamic_view mapped_snapshot::root() const {
+    return dynamic_view(addr, length);
+}
+
+size_t mapped_snapshot::size() const {
+    return length;
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "dynamic.hpp"
+#include "read_only.hpp"
+
+namespace njones {
+    class dynamic_view : public read_only_value<dynamic_view> {
+       public:
+        dynamic_view();
+        dynamic_view(const void *data, const size_t size);
+        dynamic_view(const dynamic_view &other);
+        ~dynamic_view();
+
+        dynamic_view &operator=(const dynamic_view &other);
+
+        dynamic::type get_type() const;
+
+        const char *c_str() const;
+
+        dynamic_view operator[](const size_t index) const;
+        dynamic_view operator[](const std::string &key) const;
+        dynamic_view at(const size_t index) const;
+        dynamic_view at(const std::string &key) const;
+        dynamic_view at(const char *key, const size_t size) const;
+
+        bool has(const std::string &key) const;
+        bool has(const char *key, const size_t size) const;
+
+        dynamic_view key(const size_t index) const;
+        dynamic_view value(const size_t index) const;
+
+        size_t size() const;
+
+        static uint64_t hash_key(const char *data, const size_t size);
+
+       private:
+        friend class read_only_value<dynamic_view>;
+
+        static const char *const NAME;
+
+        const char *base;
+        size_t      length;
+        uint64_t    offset;
+
+        dynamic_view(const char *base, const size_t length, const uint64_t offset);
+
+        uint64_t scalar() const;
+        template <class F>
+        void     items(F fn) const;
+        uint32_t header_type() const;
+        uint32_t header_size() const;
+        uint64_t word(const uint64_t index) const;
+        void     type_check(const dynamic::type t) const;
+        bool     find(const char *key, const size_t size, dynamic_view &out) const;
+    };
+
+    class mapped_snapshot {
+       public:
+        mapped_snapshot(const std::string &path);
+        mapped_snapshot(const mapped_snapshot &other) = delete;
+        ~mapped_snapshot();
+
+        mapped_snapshot &operator=(const mapped_snapshot &other) = delete;
+
+        dynamic_view root() const;
+
+        size_t size() const;
+
+       private:
+        void * addr;
+        size_t length;
+    };
+
+    template <class F>
+    void dynamic_view::items(F fn) const {
+        const size_t count = size();
+        for (size_t i = 0; i < count; i++)
+            if (is_map())
+                fn(key(i), value(i));
+            else
+                fn(dynamic_view(), (*this)[i]);
+    }
+}  // namespace njones
@@ -0,0 +1,265 @@
+#include "dynamic.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+
+#include "pointer.hpp"
+
+using namespace std;
+using namespace njones;
+
+enum class sort_class { MIXED, SIGNED, UNSIGNED, DOUBLE, STRING };
+
+static int type_rank(const dynamic::type t) {
+    switch (t) {
+        case dynamic::type::NONE:
+            return 0;
+        case dynamic::type::BOOL:
+            return 1;
+        case dynamic::type::INT:
+        case dynamic::type::UINT:
+        case dynamic::type::LONG:
+        case dynamic::type::ULONG:
+        case dynamic::type::DOUBLE:
+            return 2;
+        case dynamic::type::STRING:
+            return 3;
+        case dynamic::type::ARRAY:
+            return 4;
+        default:
+            return 5;
+    }
+}
+
+static bool unsigned_type(const dynamic::type t) {
+    return t == dynamic::type::UINT || t == dynamic::type::ULONG;
+}
+
+static bool signed_type(const dynamic::type t) {
+    return t == dynamic::type::INT || t == dynamic::type::LONG;
+}
+
+template <class T>
+static int order(const T &a, const T &b) {
+    return a < b ? -1 : (b < a ? 1 : 0);
+}
+
+static int compare_numbers(const dynamic &a, const dynamic &b) {
+    const dynamic::type at = a.get_type();
+    const dynamic::type bt = b.get_type();
+
+    if (unsigned_type(at) && unsigned_type(bt))
+        return order(a.as_ulong(), b.as_ulong());
+    if (signed_type(at) && signed_type(bt))
+        return order(a.as_long(), b.as_long());
+    if (signed_type(at) && unsigned_type(bt))
+        return a.as_long() < 0 ? -1 : order(static_cast<unsigned long>(a.as_long()), b.as_ulong());
+    if (unsigned_type(at) && signed_type(bt))
+        return b.as_long() < 0 ? 1 : order(a.as_ulong(), static_cast<unsigned long>(b.as_long()));
+
+    const long double x = at == dynamic::type::DOUBLE
+                              ? a.as_double()
+                              : (signed_type(at) ? static_cast<long double>(a.as_long())
+                                               : static_cast<long double>(a.as_ulong()));
+    const long double y = bt == dynamic::type::DOUBLE
+                              ? b.as_double()
+                              : (signed_type(bt) ? static_cast<long double>(b.as_long())
+                                               : static_cast<long double>(b.as_ulong()));
+    if (std::isnan(x) || std::isnan(y))
+        return order(std::isnan(x), std::isnan(y));
+    return order(x, y);
+}
+
+int dynamic::compare(const dynamic &a, const dynamic &b) {
+    if (a.v == b.v)
+        return 0;
+
+    const int ra = type_rank(a.get_type());
+    const int rb = type_rank(b.get_type());
+    if (ra != rb)
+        return order(ra, rb);
+
+    switch (a.get_type()) {
+        case type::NONE:
+            return 0;
+        case type::BOOL:
+            return order(a.as_bool(), b.as_bool());
+        case type::STRING:
+            return order(a.string_value().compare(b.string_value()), 0);
+        case type::ARRAY: {
+            const size_t n = std::min(a.size(), b.size());
+            for (size_t i = 0; i < n; i++) {
+                const int c = compare(*a.lookup(i), *b.lookup(i));
+                if (c != 0)
+                    return c;
+            }
+            return order(a.size(), b.size());
+        }
+        case type::MAP: {
+            typedef pair<dynamic, const dynamic *> entry;
+            auto entries = [](const dynamic &d) {
+                vector<entry> ret;
+                ret.reserve(d.size());
+                for (const auto item : d)
+                    ret.emplace_back(item.key(), &item.value());
+                std::sort(ret.begin(), ret.end(), [](const entry &l, const entry &r) {
+                    return compare(l.first, r.first) < 0;
+                });
+                return ret;
+            };
+            const vector<entry> ea = entries(a);
+            const vector<entry> eb = entries(b);
+            const size_t        n  = std::min(ea.size(), eb.size());
+            for (size_t i = 0; i < n; i++) {
+                int c = compare(ea[i].first, eb[i].first);
+                if (c == 0)
+                    c = compare(*ea[i].second, *eb[i].second);
+                if (c != 0)
+                    return c;
+            }
+            return order(ea.size(), eb.size());
+        }
+        default:
+            return compare_numbers(a, b);
+    }
+}
+
+void dynamic::sort() {
+    sort_array(nullptr, false);
+}
+
+void dynamic::sort(const pointer &key) {
+    sort_array(&key, false);
+}
+
+void dynamic::stable_sort() {
+    sort_array(nullptr, true);
+}
+
+void dynamic::stable_sort(const pointer &key) {
+    sort_array(&key, true);
+}
+
+static sort_class classify(const vector<const dynamic *> &keys) {
+    sort_class ret = sort_class::MIXED;
+    for (size_t i = 0; i < keys.size(); i++) {
+        const dynamic::type t = keys[i]->get_type();
+        sort_class          c = sort_class::MIXED;
+        if (signed_type(t))
+            c = sort_class::SIGNED;
+        else if (unsigned_type(t))
+            c = sort_class::UNSIGNED;
+        else if (t == dynamic::type::DOUBLE && !std::isnan(keys[i]->as_double()))
+            c = sort_class::DOUBLE;
+        else if (t == dynamic::type::STRING)
+            c = sort_class::STRING;
+
+        if (c == sort_class::MIXED || (i > 0 && c != ret))
+            return sort_class::MIXED;
+        ret = c;
+    }
+    return ret;
+}
+
+static uint64_t radix_key(const dynamic &d, const sort_class c) {
+    switch (c) {
+        case sort_class::SIGNED:
+            return static_cast<uint64_t>(d.as_long()) ^ 0x8000000000000000ULL;
+        case sort_class::UNSIGNED:
+            return d.as_ulong();
+        case sort_class::DOUBLE: {
+            const double value = d.as_double() == 0.0 ? 0.0 : d.as_double();
+            uint64_t     bits;
+            memcpy(&bits, &value, sizeof(bits));
+            return (bits & 0x8000000000000000ULL) ? ~bits : bits | 0x8000000000000000ULL;
+        }
+        default:
+            return 0;
+    }
+}
+
+static uint64_t radix_key(const string &s) {
+    uint64_t ret = 0;
+    for (size_t i = 0; i < 8; i++)
+        ret = (ret << 8) | (i < s.size() ? static_cast<unsigned char>(s[i]) : 0);
+    return ret;
+}
+
+static void radix_sort(vector<pair<uint64_t, size_t>> &items) {
+    vector<pair<uint64_t, size_t>> buffer(items.size());
+    for (size_t shift = 0; shift < 64; shift += 8) {
+        size_t counts[257] = {0};
+        for (const auto &item : items)
+            counts[((item.first >> shift) & 0xff) + 1]++;
+        if (counts[((items[0].first >> shift) & 0xff) + 1] == items.size())
+            continue;
+        for (size_t i = 1; i < 257; i++)
+            counts[i] += counts[i - 1];
+        for (const auto &item : items)
+            buffer[counts[(item.first >> shift) & 0xff]++] = item;
+        items.swap(buffer);
+    }
+}
+
+void dynamic::sort_array(const pointer *key, const bool stable) {
+    type_check(type::ARRAY);
+    const size_t n = size();
+    if (n < 2)
+        return;
+
+    static const dynamic null_value(type::NONE);
+
+    vector<const dynamic *> keys(n);
+    for (size_t i = 0; i < n; i++) {
+        const dynamic &item = *lookup(i);
+        const dynamic *k    = key == nullptr ? &item : key->find(item);
+        keys[i]             = k == nullptr ? &null_value : k;
+    }
+
+    vector<size_t>   permutation(n);
+    const sort_class c = classify(keys);
+    if (c == sort_class::MIXED) {
+        iota(permutation.begin(), permutation.end(), 0);
+        auto less = [&keys](const size_t a, const size_t b) {
+            return compare(*keys[a], *keys[b]) < 0;
+        };
+        if (stable)
+            std::stable_sort(permutation.begin(), permutation.end(), less);
+        else
+            std::sort(permutation.begin(), permutation.end(), less);
+    } else {
+        vector<pair<uint64_t, size_t>> items(n);
+        for (size_t i = 0; i < n; i++)
+            items[i] = make_pair(c == sort_class::STRING ? radix_key(keys[i]->string_value())
+                                                         : radix_key(*keys[i], c),
+                                 i);
+        radix_sort(items);
+
+        for (size_t i = 0; i < n; i++)
+            permutation[i] = items[i].second;
+
+        if (c == sort_class::STRING) {
+            for (size_t begin = 0; begin < n;) {
+                size_t end = begin + 1;
+                while (end < n && items[end].first == items[begin].first)
+                    end++;
+                if (end - begin > 1)
+                    std::stable_sort(permutation.begin() + begin, permutation.begin() + end,
+                                     [&keys](const size_t a, const size_t b) {
+                                         return compare(*keys[a], *keys[b]) < 0;
+                                     });
+                begin = end;
+            }
+        }
+    }
+
+    vector<dynamic> sorted;
+    sorted.reserve(n);
+    for (const size_t i : permutation)
+        sorted.push_back(*lookup(i));
+    dynamic *items = data();
+    for (size_t i = 0; i < n; i++)
+        items[i] = move(sorted[i]);
+}
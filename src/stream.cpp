@@ -0,0 +1,334 @@
+#include "stream.hpp"
+
+#define FMT_HEADER_ONLY
+
+#include <fmt/format.h>
+#include <limits.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <stdexcept>
+#include <system_error>
+
+using namespace std;
+using namespace njones;
+
+dynamic_sink::~dynamic_sink() {
+}
+
+void dynamic_sink::flush() {
+}
+
+callback_sink::callback_sink(const std::function<void(const char *, size_t)> &fn) : fn(fn) {
+}
+
+void callback_sink::write(const char *data, const size_t size) {
+    fn(data, size);
+}
+
+string_sink::string_sink(std::string &out) : out(out) {
+}
+
+void string_sink::write(const char *data, const size_t size) {
+    out.append(data, size);
+}
+
+fd_sink::fd_sink(const int fd) : fd(fd) {
+}
+
+void fd_sink::write(const char *data, size_t size) {
+    while (size > 0) {
+        const ssize_t n = ::write(fd, data, size);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n < 0)
+            throw system_error(errno, generic_category(),
+                               fmt::format("unable to write {} bytes to fd {}", size, fd));
+        data += n;
+        size -= static_cast<size_t>(n);
+    }
+}
+
+writev_sink::writev_sink(const int fd, const size_t batch)
+    : fd(fd), chunks(std::max(std::min(batch, static_cast<size_t>(IOV_MAX)), size_t(1))), used(0) {
+}
+
+writev_sink::~writev_sink() {
+    try {
+        flush();
+    } catch (...) {
+    }
+}
+
+void writev_sink::write(const char *data, const size_t size) {
+    if (used == chunks.size())
+        flush();
+    chunks[used++].assign(data, size);
+    if (used == chunks.size())
+        flush();
+}
+
+void writev_sink::flush() {
+    vector<iovec> iov(used);
+    for (size_t i = 0; i < used; i++) {
+        iov[i].iov_base = &chunks[i][0];
+        iov[i].iov_len  = chunks[i].size();
+    }
+
+    size_t first = 0;
+    while (first < iov.size()) {
+        const ssize_t n = ::writev(fd, &iov[first], static_cast<int>(iov.size() - first));
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n < 0)
+            throw system_error(errno, generic_category(),
+                               fmt::format("unable to write {} chunks to fd {}", used, fd));
+
+        size_t remaining = static_cast<size_t>(n);
+        while (first < iov.size() && remaining >= iov[first].iov_len)
+            remaining -= iov[first++].iov_len;
+        if (remaining > 0) {
+            iov[first].iov_base = static_cast<char *>(iov[first].iov_base) + remaining;
+            iov[first].iov_len -= remaining;
+        }
+    }
+    used = 0;
+}
+
+dynamic_stream::dynamic_stream(dynamic_sink &sink, const size_t chunk)
+    : sink(sink), chunk(std::max(chunk, static_cast<size_t>(1))), total(0) {
+    buffer.reserve(this->chunk);
+}
+
+dynamic_stream::~dynamic_stream() {
+    try {
+        flush();
+    } catch (...) {
+    }
+}
+
+void dynamic_stream::write(const dynamic &d, const bool pretty) {
+    d.serialize(*this, pretty, 0);
+    if ((d.is_array() || d.is_map()) && !d.empty())
+        write(pretty && d.is_map() ? "\n" : " ", 1);
+}
+
+void dynamic_stream::write(const char *data, size_t size) {
+    total += size;
+    if (buffer.size() + size < chunk) {
+        buffer.append(data, size);
+        return;
+    }
+
+    if (!buffer.empty()) {
+        const size_t n = chunk - buffer.size();
+        buffer.append(data, n);
+        sink.write(buffer.data(), buffer.size());
+        buffer.clear();
+        data += n;
+        size -= n;
+    }
+    for (; size >= chunk; data += chunk, size -= chunk)
+        sink.write(data, chunk);
+    buffer.append(data, size);
+}
+
+void dynamic_stream::flush() {
+    if (!buffer.empty()) {
+        sink.write(buffer.data(), buffer.size());
+        buffer.clear();
+    }
+    sink.flush();
+}
+
+size_t dynamic_stream::written() const {
+    return total;
+}
+
+dynamic_writer::dynamic_writer(dynamic_sink &sink, const bool pretty, const size_t chunk)
+    : stream(sink, chunk), pretty(pretty), done(false) {
+}
+
+dynamic_writer::dynamic_writer(std::string &out, const bool pretty)
+    : owned(new string_sink(out)), stream(*owned), pretty(pretty), done(false) {
+}
+
+dynamic_writer::~dynamic_writer() {
+    try {
+        flush();
+    } catch (...) {
+    }
+}
+
+dynamic_writer &dynamic_writer::begin_object() {
+    begin(true);
+    return *this;
+}
+
+dynamic_writer &dynamic_writer::end_object() {
+    end(true);
+    return *this;
+}
+
+dynamic_writer &dynamic_writer::begin_array() {
+    begin(false);
+    return *this;
+}
+
+dynamic_writer &dynamic_writer::end_array() {
+    end(false);
+    return *this;
+}
+
+dynamic_writer &dynamic_writer::key(const std::string &key) {
+    if (frames.empty() || !frames.back().map)
+        throw domain_error("dynamic writer key must be inside an object");
+    frame &top = frames.back();
+    if (top.keyed)
+        throw domain_error(fmt::format("dynamic writer key {} follows a key without a value", key));
+
+    if (top.count > 0)
+        stream.write(", ", 2);
+    if (pretty) {
+        const string prefix((top.indent + 1) * 4, ' ');
+        stream.write("\n", 1);
+        stream.write(prefix.data(), prefix.size());
+    }
+    dynamic::serialize(stream, key);
+    stream.write(": ", 2);
+    top.keyed = true;
+    return *this;
+}
+
+dynamic_writer &dynamic_writer::null() {
+    begin_value();
+    stream.write("null", 4);
+    finish(false, false, true);
+    return *this;
+}
+
+dynamic_writer &dynamic_writer::value(const int val) {
+    number("%d", val);
+    return *this;
+}
+
+dynamic_writer &dynamic_writer::value(const unsigned int val) {
+    number("%u", val);
+    return *this;
+}
+
+dynamic_writer &dynamic_writer::value(const long val) {
+    number("%ld", val);
+    return *this;
+}
+
+dynamic_writer &dynamic_writer::value(const unsigned long val) {
+    number("%lu", val);
+    return *this;
+}
+
+dynamic_writer &dynamic_writer::value(const double val) {
+    number("%g", val);
+    return *this;
+}
+
+dynamic_writer &dynamic_writer::value(const bool val) {
+    begin_value();
+    if (val)
+        stream.write("true", 4);
+    else
+        stream.write("false", 5);
+    finish(false, false, true);
+    return *this;
+}
+
+dynamic_writer &dynamic_writer::value(const char *val) {
+    return value(string(val));
+}
+
+dynamic_writer &dynamic_writer::value(const std::string &val) {
+    begin_value();
+    dynamic::serialize(stream, val);
+    finish(false, false, true);
+    return *this;
+}
+
+dynamic_writer &dynamic_writer::write(const dynamic &d) {
+    d.serialize(stream, pretty, begin_value());
+    finish(d.is_array() || d.is_map(), d.is_map(), (d.is_array() || d.is_map()) && d.empty());
+    return *this;
+}
+
+void dynamic_writer::flush() {
+    stream.flush();
+}
+
+bool dynamic_writer::complete() const {
+    return done;
+}
+
+size_t dynamic_writer::depth() const {
+    return frames.size();
+}
+
+size_t dynamic_writer::begin_value() {
+    if (frames.empty()) {
+        if (done)
+            throw domain_error("dynamic writer already wrote a complete value");
+        return 0;
+    }
+
+    frame &top = frames.back();
+    if (top.map) {
+        if (!top.keyed)
+            throw domain_error("dynamic writer object value requires a key");
+        top.keyed = false;
+        top.count++;
+        return top.indent + 1;
+    }
+    if (top.count++ > 0)
+        stream.write(", ", 2);
+    return top.indent;
+}
+
+template <class T>
+void dynamic_writer::number(const char *format, const T val) {
+    char buffer[32];
+    begin_value();
+    stream.write(buffer, snprintf(buffer, sizeof(buffer), format, val));
+    finish(false, false, true);
+}
+
+void dynamic_writer::begin(const bool map) {
+    const size_t indent = begin_value();
+    stream.write(map ? "{" : "[", 1);
+    frames.push_back(frame{map, false, 0, indent});
+}
+
+void dynamic_writer::end(const bool map) {
+    if (frames.empty() || frames.back().map != map)
+        throw domain_error(fmt::format("dynamic writer {} does not close an open {}",
+                                       map ? "end_object" : "end_array", map ? "object" : "array"));
+    const frame top = frames.back();
+    if (top.keyed)
+        throw domain_error("dynamic writer object ends after a key without a value");
+
+    if (map && pretty && top.count > 0) {
+        const string prefix(top.indent * 4, ' ');
+        stream.write("\n", 1);
+        stream.write(prefix.data(), prefix.size());
+    }
+    stream.write(map ? "}" : "]", 1);
+    frames.pop_back();
+    finish(true, map, top.count == 0);
+}
+
+void dynamic_writer::finish(const bool container, const bool map, const bool empty) {
+    if (!frames.empty())
+        return;
+    done = true;
+    if (container && !empty)
+        stream.write(pretty && map ? "\n" : " ", 1);
+}
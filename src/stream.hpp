@@ -0,0 +1,142 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "dynamic.hpp"
+
+namespace njones {
+    class dynamic_sink {
+       public:
+        virtual ~dynamic_sink();
+
+        virtual void write(const char *data, const size_t size) = 0;
+        virtual void flush();
+    };
+
+    class callback_sink : public dynamic_sink {
+       public:
+        callback_sink(const std::function<void(const char *, size_t)> &fn);
+
+        void write(const char *data, const size_t size) override;
+
+       private:
+        std::function<void(const char *, size_t)> fn;
+    };
+
+    class string_sink : public dynamic_sink {
+       public:
+        string_sink(std::string &out);
+
+        void write(const char *data, const size_t size) override;
+
+       private:
+        std::string &out;
+    };
+
+    class fd_sink : public dynamic_sink {
+       public:
+        fd_sink(const int fd);
+
+        void write(const char *data, const size_t size) override;
+
+       private:
+        int fd;
+    };
+
+    class writev_sink : public dynamic_sink {
+       public:
+        writev_sink(const int fd, const size_t batch = 16);
+        writev_sink(const writev_sink &other) = delete;
+        ~writev_sink();
+
+        writev_sink &operator=(const writev_sink &other) = delete;
+
+        void write(const char *data, const size_t size) override;
+        void flush() override;
+
+       private:
+        int                      fd;
+        std::vector<std::string> chunks;
+        size_t                   used;
+    };
+
+    class dynamic_stream {
+       public:
+        static const size_t CHUNK_SIZE = 65536;
+
+        dynamic_stream(dynamic_sink &sink, const size_t chunk = CHUNK_SIZE);
+        dynamic_stream(const dynamic_stream &other) = delete;
+        ~dynamic_stream();
+
+        dynamic_stream &operator=(const dynamic_stream &other) = delete;
+
+        void write(const dynamic &d, const bool pretty = false);
+        void write(const char *data, const size_t size);
+        void flush();
+
+        size_t written() const;
+
+       private:
+        dynamic_sink &sink;
+        size_t        chunk;
+        std::string   buffer;
+        size_t        total;
+    };
+
+    class dynamic_writer {
+       public:
+        dynamic_writer(dynamic_sink &sink, const bool pretty = false,
+                       const size_t chunk = dynamic_stream::CHUNK_SIZE);
+        dynamic_writer(std::string &out, const bool pretty = false);
+        dynamic_writer(const dynamic_writer &other) = delete;
+        ~dynamic_writer();
+
+        dynamic_writer &operator=(const dynamic_writer &other) = delete;
+
+        dynamic_writer &begin_object();
+        dynamic_writer &end_object();
+        dynamic_writer &begin_array();
+        dynamic_writer &end_array();
+        dynamic_writer &key(const std::string &key);
+
+        dynamic_writer &null();
+        dynamic_writer &value(const int val);
+        dynamic_writer &value(const unsigned int val);
+        dynamic_writer &value(const long val);
+        dynamic_writer &value(const unsigned long val);
+        dynamic_writer &value(const double val);
+        dynamic_writer &value(const bool val);
+        dynamic_writer &value(const char *val);
+        dynamic_writer &value(const std::string &val);
+        dynamic_writer &write(const dynamic &d);
+
+        void flush();
+
+        bool   complete() const;
+        size_t depth() const;
+
+       private:
+        struct frame {
+            bool   map;
+            bool   keyed;
+            size_t count;
+            size_t indent;
+        };
+
+        std::unique_ptr<dynamic_sink> owned;
+        dynamic_stream                stream;
+        bool                          pretty;
+        bool                          done;
+        std::vector<frame>            frames;
+
+        size_t begin_value();
+        template <class T>
+        void number(const char *format, const T val);
+        void   begin(const bool map);
+        void   end(const bool map);
+        void   finish(const bool container, const bool map, const bool empty);
+    };
+}  // namespace njones
@@ -0,0 +1,348 @@
+#include "tape.hpp"
+
+#define FMT_HEADER_ONLY
+
+#include <fmt/format.h>
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+using namespace std;
+using namespace njones;
+
+const uint64_t dynamic_tape::TAG_END_ARRAY = 10;
+const uint64_t dynamic_tape::TAG_END_MAP   = 11;
+const int      dynamic_tape::TAG_SHIFT     = 56;
+const uint64_t dynamic_tape::PAYLOAD_MASK  = (1UL << 56) - 1;
+const uint64_t dynamic_tape::COUNT_MAX     = 0xFFFFFF;
+
+const char *const tape_value::NAME = "tape value";
+
+static int compare_keys(const char *a, const size_t na, const char *b, const size_t nb) {
+    const int cmp = memcmp(a, b, min(na, nb));
+    if (cmp != 0 || na == nb)
+        return cmp;
+    return na < nb ? -1 : 1;
+}
+
+tape_value::tape_value() : doc(nullptr), index(0) {
+}
+
+tape_value::tape_value(const dynamic_tape *doc, const size_t index) : doc(doc), index(index) {
+}
+
+dynamic::type tape_value::get_type() const {
+    if (doc == nullptr)
+        return dynamic::type::NONE;
+    return static_cast<dynamic::type>(word() >> dynamic_tape::TAG_SHIFT);
+}
+
+const char *tape_value::c_str() const {
+    type_check(dynamic::type::STRING);
+    return doc->arena.data() + (word() & dynamic_tape::PAYLOAD_MASK) + sizeof(uint32_t);
+}
+
+tape_value tape_value::operator[](const size_t i) const {
+    type_check(dynamic::type::ARRAY);
+    const uint32_t *elements = offsets();
+    if (i >= elements[0])
+        throw range_error(
+            fmt::format("tape value index out of range {} > {}", i, elements[0] - 1));
+    return tape_value(doc, elements[i + 1]);
+}
+
+tape_value tape_value::operator[](const std::string &key) const {
+    tape_value ret;
+    if (!find(key.data(), key.size(), ret))
+        throw range_error(fmt::format("tape value has no member: {}", key));
+    return ret;
+}
+
+tape_value tape_value::at(const size_t i) const {
+    return (*this)[i];
+}
+
+tape_value tape_value::at(const std::string &key) const {
+    return (*this)[key];
+}
+
+tape_value tape_value::front() const {
+    return at(0);
+}
+
+tape_value tape_value::back() const {
+    return at(size() - 1);
+}
+
+bool tape_value::has(const std::string &key) const {
+    tape_value ret;
+    return find(key.data(), key.size(), ret);
+}
+
+tape_value::iterator tape_value::begin() const {
+    const dynamic::type t = get_type();
+    if (t != dynamic::type::ARRAY && t != dynamic::type::MAP)
+        throw domain_error("tape value is not an array or a map");
+    return tape_iterator(doc, index + 1, t == dynamic::type::MAP);
+}
+
+tape_value::iterator tape_value::end() const {
+    const dynamic::type t = get_type();
+    if (t != dynamic::type::ARRAY && t != dynamic::type::MAP)
+        throw domain_error("tape value is not an array or a map");
+    return tape_iterator(doc, next() - 1, t == dynamic::type::MAP);
+}
+
+tape_value::iterator tape_value::cbegin() const {
+    return begin();
+}
+
+tape_value::iterator tape_value::cend() const {
+    return end();
+}
+
+size_t tape_value::size() const {
+    switch (get_type()) {
+        case dynamic::type::STRING:
+            return string_size();
+        case dynamic::type::ARRAY:
+        case dynamic::type::MAP: {
+            const size_t count = (word() & dynamic_tape::PAYLOAD_MASK) >> 32;
+            if (count < dynamic_tape::COUNT_MAX)
+                return count;
+            if (get_type() == dynamic::type::ARRAY)
+                return offsets()[0];
+            size_t n = 0;
+            for (auto iter = begin(); iter != end(); ++iter)
+                n++;
+            return n;
+        }
+        default:
+            throw domain_error("tape value type must be string, array, or map to have a size");
+    }
+}
+
+size_t tape_value::next() const {
+    switch (get_type()) {
+        case dynamic::type::ARRAY:
+        case dynamic::type::MAP:
+            return (word() & 0xFFFFFFFF) + 1;
+        case dynamic::type::INT:
+        case dynamic::type::UINT:
+        case dynamic::type::LONG:
+        case dynamic::type::ULONG:
+        case dynamic::type::DOUBLE:
+            return index + 2;
+        default:
+            return index + 1;
+    }
+}
+
+std::string tape_value::str(const bool pretty) const {
+    return to_dynamic().str(pretty);
+}
+
+uint64_t tape_value::scalar() const {
+    if (get_type() == dynamic::type::BOOL)
+        return word() & dynamic_tape::PAYLOAD_MASK;
+    return doc->tape[index + 1];
+}
+
+uint64_t tape_value::word() const {
+    return doc->tape[index];
+}
+
+uint32_t tape_value::string_size() const {
+    uint32_t s;
+    memcpy(&s, doc->arena.data() + (word() & dynamic_tape::PAYLOAD_MASK), sizeof(s));
+    return s;
+}
+
+// Arrays and maps keep a run of tape positions in the offsets vector, prefixed with its length:
+// every element of an array, or the string keys of a map sorted by their bytes. The end word of
+// the container holds where the run starts.
+const uint32_t *tape_value::offsets() const {
+    return doc->offsets.data() + (doc->tape[next() - 1] & dynamic_tape::PAYLOAD_MASK);
+}
+
+void tape_value::type_check(const dynamic::type t) const {
+    if (get_type() != t)
+        throw domain_error("tape value has the wrong type for this operation");
+}
+
+bool tape_value::find(const char *key, const size_t size, tape_value &out) const {
+    type_check(dynamic::type::MAP);
+    const uint32_t *keys  = offsets();
+    size_t          first = 1;
+    size_t          last  = keys[0] + 1;
+    while (first < last) {
+        const size_t     mid = first + (last - first) / 2;
+        const tape_value k(doc, keys[mid]);
+        const int        cmp = compare_keys(k.c_str(), k.string_size(), key, size);
+        if (cmp == 0) {
+            out = tape_value(doc, k.next());
+            return true;
+        }
+        if (cmp < 0)
+            first = mid + 1;
+        else
+            last = mid;
+    }
+    return false;
+}
+
+tape_iterator_value::tape_iterator_value(const tape_value &key, const tape_value &v)
+    : _key(key), v(v) {
+}
+
+const tape_value &tape_iterator_value::key() const {
+    return _key;
+}
+
+const tape_value &tape_iterator_value::value() const {
+    return v;
+}
+
+tape_iterator::tape_iterator(const dynamic_tape *doc, const size_t index, const bool map)
+    : doc(doc), index(index), map(map) {
+}
+
+tape_iterator &tape_iterator::operator++() {
+    index = tape_value(doc, index).next();
+    if (map)
+        index = tape_value(doc, index).next();
+    return *this;
+}
+
+tape_iterator tape_iterator::operator++(int) {
+    tape_iterator tmp(*this);
+    ++(*this);
+    return tmp;
+}
+
+bool tape_iterator::operator==(const tape_iterator &rhs) const {
+    return doc == rhs.doc && index == rhs.index;
+}
+
+bool tape_iterator::operator!=(const tape_iterator &rhs) const {
+    return !(*this == rhs);
+}
+
+tape_iterator::value tape_iterator::operator*() const {
+    if (map)
+        return tape_iterator_value(tape_value(doc, index),
+                                   tape_value(doc, tape_value(doc, index).next()));
+    return tape_iterator_value(tape_value(), tape_value(doc, index));
+}
+
+dynamic_tape::dynamic_tape() {
+    append(dynamic(nullptr));
+}
+
+dynamic_tape::dynamic_tape(const dynamic &d) {
+    append(d);
+    tape.shrink_to_fit();
+    arena.shrink_to_fit();
+    offsets.shrink_to_fit();
+}
+
+tape_value dynamic_tape::root() const {
+    return tape_value(this, 0);
+}
+
+tape_value dynamic_tape::operator[](const size_t index) const {
+    return root()[index];
+}
+
+tape_value dynamic_tape::operator[](const std::string &key) const {
+    return root()[key];
+}
+
+dynamic dynamic_tape::to_dynamic() const {
+    return root().to_dynamic();
+}
+
+size_t dynamic_tape::tape_size() const {
+    return tape.size();
+}
+
+size_t dynamic_tape::arena_size() const {
+    return arena.size();
+}
+
+void dynamic_tape::append(const dynamic &d) {
+    const uint64_t tag = static_cast<uint64_t>(d.get_type());
+    switch (d.get_type()) {
+        case dynamic::type::NONE:
+            append_word(tag, 0);
+            break;
+        case dynamic::type::INT:
+        case dynamic::type::LONG:
+            append_word(tag, 0);
+            tape.push_back(static_cast<uint64_t>(d.as_long()));
+            break;
+        case dynamic::type::UINT:
+        case dynamic::type::ULONG:
+            append_word(tag, 0);
+            tape.push_back(d.as_ulong());
+            break;
+        case dynamic::type::DOUBLE: {
+            const double val = d.as_double();
+            uint64_t     bits;
+            memcpy(&bits, &val, sizeof(bits));
+            append_word(tag, 0);
+            tape.push_back(bits);
+            break;
+        }
+        case dynamic::type::BOOL:
+            append_word(tag, d.as_bool() ? 1 : 0);
+            break;
+        case dynamic::type::STRING: {
+            const string val = d.as_string();
+            if (val.size() > UINT32_MAX)
+                throw length_error("tape string is too large");
+            const uint32_t len = static_cast<uint32_t>(val.size());
+            append_word(tag, arena.size());
+            arena.append(reinterpret_cast<const char *>(&len), sizeof(len));
+            arena.append(val);
+            arena.push_back('\0');
+            break;
+        }
+        case dynamic::type::ARRAY:
+        case dynamic::type::MAP: {
+            const size_t     start = tape.size();
+            vector<uint32_t> positions;
+            positions.reserve(d.size());
+            append_word(tag, 0);
+            for (const auto item : d) {
+                if (d.is_map()) {
+                    if (item.key().is_string())
+                        positions.push_back(static_cast<uint32_t>(tape.size()));
+                    append(item.key());
+                } else
+                    positions.push_back(static_cast<uint32_t>(tape.size()));
+                append(item.value());
+            }
+            const size_t end = tape.size();
+            if (end > UINT32_MAX || offsets.size() + positions.size() >= UINT32_MAX)
+                throw length_error("tape is too large");
+            if (d.is_map())
+                sort(positions.begin(), positions.end(),
+                     [this](const uint32_t a, const uint32_t b) {
+                         const tape_value ka(this, a);
+                         const tape_value kb(this, b);
+                         return compare_keys(ka.c_str(), ka.size(), kb.c_str(), kb.size()) < 0;
+                     });
+            append_word(d.is_map() ? TAG_END_MAP : TAG_END_ARRAY, offsets.size());
+            offsets.push_back(static_cast<uint32_t>(positions.size()));
+            offsets.insert(offsets.end(), positions.begin(), positions.end());
+            const uint64_t count = d.size() < COUNT_MAX ? d.size() : COUNT_MAX;
+            tape[start]          = (tag << TAG_SHIFT) | (count << 32) | end;
+            break;
+        }
+    }
+}
+
+void dynamic_tape::append_word(const uint64_t tag, const uint64_t payload) {
+    tape.push_back((tag << TAG_SHIFT) | (payload & PAYLOAD_MASK));
+}
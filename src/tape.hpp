@@ -0,0 +1,132 @@
+#pragma once
+
+#include <cstdint>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "dynamic.hpp"
+#include "read_only.hpp"
+
+namespace njones {
+    class dynamic_tape;
+    class tape_iterator;
+
+    class tape_value : public read_only_value<tape_value> {
+       public:
+        typedef tape_iterator iterator;
+        typedef tape_iterator const_iterator;
+
+        tape_value();
+        tape_value(const dynamic_tape *doc, const size_t index);
+
+        dynamic::type get_type() const;
+
+        const char *c_str() const;
+
+        tape_value operator[](const size_t index) const;
+        tape_value operator[](const std::string &key) const;
+        tape_value at(const size_t index) const;
+        tape_value at(const std::string &key) const;
+        tape_value front() const;
+        tape_value back() const;
+
+        bool has(const std::string &key) const;
+
+        iterator begin() const;
+        iterator end() const;
+        iterator cbegin() const;
+        iterator cend() const;
+
+        size_t size() const;
+        size_t next() const;
+
+        std::string str(const bool pretty = false) const;
+
+       private:
+        friend class read_only_value<tape_value>;
+
+        static const char *const NAME;
+
+        const dynamic_tape *doc;
+        size_t              index;
+
+        uint64_t        scalar() const;
+        template <class F>
+        void            items(F fn) const;
+        uint64_t        word() const;
+        uint32_t        string_size() const;
+        const uint32_t *offsets() const;
+        void            type_check(const dynamic::type t) const;
+        bool            find(const char *key, const size_t size, tape_value &out) const;
+    };
+
+    class tape_iterator_value {
+       public:
+        tape_iterator_value(const tape_value &key, const tape_value &v);
+
+        const tape_value &key() const;
+        const tape_value &value() const;
+
+       private:
+        tape_value _key;
+        tape_value v;
+    };
+
+    class tape_iterator : public std::iterator<std::forward_iterator_tag, tape_iterator_value> {
+       public:
+        typedef tape_iterator_value value;
+
+        tape_iterator(const dynamic_tape *doc, const size_t index, const bool map);
+
+        tape_iterator &operator++();
+        tape_iterator  operator++(int);
+        bool           operator==(const tape_iterator &rhs) const;
+        bool           operator!=(const tape_iterator &rhs) const;
+
+        tape_iterator::value operator*() const;
+
+       private:
+        const dynamic_tape *doc;
+        size_t              index;
+        bool                map;
+    };
+
+    class dynamic_tape {
+       public:
+        dynamic_tape();
+        dynamic_tape(const dynamic &d);
+
+        tape_value root() const;
+
+        tape_value operator[](const size_t index) const;
+        tape_value operator[](const std::string &key) const;
+
+        dynamic to_dynamic() const;
+
+        size_t tape_size() const;
+        size_t arena_size() const;
+
+       private:
+        friend class tape_value;
+
+        static const uint64_t TAG_END_ARRAY;
+        static const uint64_t TAG_END_MAP;
+        static const int      TAG_SHIFT;
+        static const uint64_t PAYLOAD_MASK;
+        static const uint64_t COUNT_MAX;
+
+        std::vector<uint64_t> tape;
+        std::string           arena;
+        std::vector<uint32_t> offsets;
+
+        void append(const dynamic &d);
+        void append_word(const uint64_t tag, const uint64_t payload);
+    };
+
+    template <class F>
+    void tape_value::items(F fn) const {
+        for (const auto item : *this)
+            fn(item.key(), item.value());
+    }
+}  // namespace njones
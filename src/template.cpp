@@ -0,0 +1,153 @@
+#include "template.hpp"
+
+#define FMT_HEADER_ONLY
+
+#include <fmt/format.h>
+#include <cstdio>
+#include <stdexcept>
+
+using namespace std;
+using namespace njones;
+
+dynamic_template::dynamic_template(const dynamic &doc, const bool pretty) : pretty(pretty) {
+    doc.serialize(text, pretty, 0, [this](const dynamic &d, const size_t indent) {
+        return placeholder(d, indent);
+    });
+    if ((doc.is_array() || doc.is_map()) && !doc.empty())
+        text += pretty && doc.is_map() ? "\n" : " ";
+    segments.push_back(
+        segment{segments.empty() ? 0 : segments.back().end, text.size(), string::npos, 0});
+}
+
+size_t dynamic_template::size() const {
+    return slots.size();
+}
+
+size_t dynamic_template::slot(const std::string &name) const {
+    auto iter = names.find(name);
+    if (iter == names.end())
+        throw range_error(fmt::format("dynamic template has no slot: {}", name));
+    return iter->second;
+}
+
+const std::string &dynamic_template::name(const size_t slot) const {
+    if (slot >= slots.size())
+        throw range_error(fmt::format("dynamic template slot out of range {} >= {}", slot, slots.size()));
+    return slots[slot].name;
+}
+
+bool dynamic_template::typed(const size_t slot) const {
+    name(slot);
+    return slots[slot].typed;
+}
+
+dynamic::type dynamic_template::type(const size_t slot) const {
+    name(slot);
+    return slots[slot].t;
+}
+
+std::string dynamic_template::render(const std::vector<dynamic> &values) const {
+    string ret;
+    render(values, ret);
+    return ret;
+}
+
+std::string dynamic_template::render(const dynamic &values) const {
+    vector<dynamic> ordered;
+    ordered.reserve(slots.size());
+    for (const slot_info &info : slots) {
+        if (!values.has(info.name))
+            throw range_error(fmt::format("dynamic template has no value for slot: {}", info.name));
+        ordered.push_back(values.at(info.name));
+    }
+    return render(ordered);
+}
+
+void dynamic_template::render(const std::vector<dynamic> &values, std::string &out) const {
+    if (values.size() != slots.size())
+        throw range_error(
+            fmt::format("dynamic template expects {} values, got {}", slots.size(), values.size()));
+
+    out.reserve(out.size() + text.size() + 16 * segments.size());
+    for (const segment &s : segments) {
+        out.append(text, s.begin, s.end - s.begin);
+        if (s.slot != string::npos)
+            append(s.slot, values[s.slot], s.indent, out);
+    }
+}
+
+bool dynamic_template::placeholder(const dynamic &d, const size_t indent) {
+    if (!d.is_string())
+        return false;
+    const string &s = d.string_value();
+    if (s.size() < 5 || s.compare(0, 2, "{{") != 0 || s.compare(s.size() - 2, 2, "}}") != 0)
+        return false;
+
+    const string body  = s.substr(2, s.size() - 4);
+    const size_t colon = body.find(':');
+    slot_info    info{body.substr(0, colon), false, dynamic::type::NONE};
+    if (colon != string::npos && body.substr(colon + 1) != "any") {
+        const string type_name = body.substr(colon + 1);
+        for (const auto &p : dynamic::TYPE_NAME)
+            if (p.first != dynamic::type::NONE && p.second == type_name) {
+                info.typed = true;
+                info.t     = p.first;
+            }
+        if (!info.typed)
+            throw domain_error(
+                fmt::format("dynamic template slot {} has unknown type {}", info.name, type_name));
+    }
+
+    auto   iter  = names.find(info.name);
+    size_t index = slots.size();
+    if (iter == names.end()) {
+        names.emplace(info.name, index);
+        slots.push_back(info);
+    } else {
+        index = iter->second;
+        if (slots[index].typed != info.typed || slots[index].t != info.t)
+            throw domain_error(
+                fmt::format("dynamic template slot {} is declared with conflicting types", info.name));
+    }
+
+    segments.push_back(segment{segments.empty() ? 0 : segments.back().end, text.size(), index, indent});
+    return true;
+}
+
+void dynamic_template::append(const size_t slot, const dynamic &val, const size_t indent,
+                              std::string &out) const {
+    const slot_info &info = slots[slot];
+    char             number[32];
+    if (!info.typed) {
+        val.serialize(out, pretty, indent);
+        return;
+    }
+    if (val.get_type() != info.t)
+        throw domain_error(fmt::format("dynamic template slot {} expects {}, got {}", info.name,
+                                       dynamic::TYPE_NAME.at(info.t),
+                                       dynamic::TYPE_NAME.at(val.get_type())));
+
+    switch (info.t) {
+        case dynamic::type::INT:
+            out.append(number, snprintf(number, sizeof(number), "%d", val.as_int()));
+            break;
+        case dynamic::type::UINT:
+            out.append(number, snprintf(number, sizeof(number), "%u", val.as_uint()));
+            break;
+        case dynamic::type::LONG:
+            out.append(number, snprintf(number, sizeof(number), "%ld", val.as_long()));
+            break;
+        case dynamic::type::ULONG:
+            out.append(number, snprintf(number, sizeof(number), "%lu", val.as_ulong()));
+            break;
+        case dynamic::type::DOUBLE:
+            out.append(number, snprintf(number, sizeof(number), "%g", val.as_double()));
+            break;
+        case dynamic::type::BOOL:
+            out += val.as_bool() ? "true" : "false";
+            break;
+        default:
+            val.serialize(out, pretty, indent);
+            break;
+    }
+}
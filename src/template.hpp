@@ -0,0 +1,48 @@
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "dynamic.hpp"
+
+namespace njones {
+    class dynamic_template {
+       public:
+        dynamic_template(const dynamic &doc, const bool pretty = false);
+
+        size_t             size() const;
+        size_t             slot(const std::string &name) const;
+        const std::string &name(const size_t slot) const;
+        bool               typed(const size_t slot) const;
+        dynamic::type      type(const size_t slot) const;
+
+        std::string render(const std::vector<dynamic> &values) const;
+        std::string render(const dynamic &values) const;
+        void        render(const std::vector<dynamic> &values, std::string &out) const;
+
+       private:
+        struct slot_info {
+            std::string   name;
+            bool          typed;
+            dynamic::type t;
+        };
+
+        struct segment {
+            size_t begin;
+            size_t end;
+            size_t slot;
+            size_t indent;
+        };
+
+        bool                                    pretty;
+        std::string                             text;
+        std::vector<segment>                    segments;
+        std::vector<slot_info>                  slots;
+        std::unordered_map<std::string, size_t> names;
+
+        bool placeholder(const dynamic &d, const size_t indent);
+        void append(const size_t slot, const dynamic &val, const size_t indent,
+                    std::string &out) const;
+    };
+}  // namespace njones
@@ -0,0 +1,124 @@
+#include <cxxtest/TestSuite.h>
+#include <limits>
+#include <sstream>
+
+#include "cbor.hpp"
+#include "dynamic.hpp"
+
+using namespace std;
+
+class cbor_test_suite : public CxxTest::TestSuite {
+   public:
+    void test_encode_integers() {
+        TS_ASSERT(njones::cbor::encode(0) == "\x00"s);
+        TS_ASSERT(njones::cbor::encode(23) == "\x17"s);
+        TS_ASSERT(njones::cbor::encode(24) == "\x18\x18"s);
+        TS_ASSERT(njones::cbor::encode(1000) == "\x19\x03\xe8"s);
+        TS_ASSERT(njones::cbor::encode(-1) == "\x20"s);
+        TS_ASSERT(njones::cbor::encode(-1000) == "\x39\x03\xe7"s);
+        TS_ASSERT(njones::cbor::encode(numeric_limits<unsigned long>::max()) ==
+                  "\x1b\xff\xff\xff\xff\xff\xff\xff\xff"s);
+    }
+
+    void test_encode_simple() {
+        TS_ASSERT(njones::cbor::encode(nullptr) == "\xf6"s);
+        TS_ASSERT(njones::cbor::encode(false) == "\xf4"s);
+        TS_ASSERT(njones::cbor::encode(true) == "\xf5"s);
+        TS_ASSERT(njones::cbor::encode(1.5) == "\xfa\x3f\xc0\x00\x00"s);
+        TS_ASSERT(njones::cbor::encode(1.1) == "\xfb\x3f\xf1\x99\x99\x99\x99\x99\x9a"s);
+        TS_ASSERT(njones::cbor::encode("IETF") == "\x64IETF"s);
+        TS_ASSERT(njones::cbor::encode(numeric_limits<double>::infinity()) ==
+                  "\xfa\x7f\x80\x00\x00"s);
+        TS_ASSERT(njones::cbor::encode(1e300) == "\xfb\x7e\x37\xe4\x3c\x88\x00\x75\x9c"s);
+        TS_ASSERT(njones::cbor::decode(njones::cbor::encode(-1e300)).as_double() == -1e300);
+    }
+
+    void test_round_trip() {
+        njones::dynamic d;
+        d["int"]    = -42;
+        d["ulong"]  = numeric_limits<unsigned long>::max();
+        d["long"]   = numeric_limits<long>::min();
+        d["double"] = 3.14159;
+        d["bool"]   = true;
+        d["null"]   = nullptr;
+        d["string"] = "a string";
+        d["array"].set_type(njones::dynamic::type::ARRAY);
+        d["array"].push_back(1);
+        d["array"].push_back("two");
+        d["array"].push_back(3.5);
+        d["map"]["nested"] = "value";
+
+        njones::dynamic decoded = njones::cbor::decode(njones::cbor::encode(d));
+        TS_ASSERT(decoded.size() == d.size());
+        TS_ASSERT(decoded["int"].as_int() == -42);
+        TS_ASSERT(decoded["ulong"].as_ulong() == numeric_limits<unsigned long>::max());
+        TS_ASSERT(decoded["long"].as_long() == numeric_limits<long>::min());
+        TS_ASSERT(decoded["double"].as_double() == 3.14159);
+        TS_ASSERT(decoded["bool"].as_bool() == true);
+        TS_ASSERT(decoded["null"].is_null());
+        TS_ASSERT(decoded["string"].as_string() == "a string");
+        TS_ASSERT(decoded["array"] == d["array"]);
+        TS_ASSERT(decoded["array"].capacity() == 3);
+        TS_ASSERT(decoded["map"]["nested"].as_string() == "value");
+    }
+
+    void test_indefinite_array_stream() {
+        ostringstream        out;
+        njones::cbor_encoder encoder(out);
+        encoder.begin_array();
+        for (int i = 0; i < 100000; i++)
+            encoder.write(i);
+        encoder.end();
+        encoder.flush();
+
+        njones::dynamic decoded = njones::cbor::decode(out.str());
+        TS_ASSERT(decoded.is_array());
+        TS_ASSERT(decoded.size() == 100000);
+        TS_ASSERT(decoded[99999].as_int() == 99999);
+    }
+
+    void test_indefinite_map() {
+        njones::cbor_encoder encoder;
+        encoder.begin_map();
+        encoder.write("a");
+        encoder.write(1);
+        encoder.write("b");
+        encoder.begin_array(2);
+        encoder.write(2);
+        encoder.write(3);
+        encoder.end();
+
+        njones::dynamic decoded = njones::cbor::decode(encoder.str());
+        TS_ASSERT(decoded["a"].as_int() == 1);
+        TS_ASSERT(decoded["b"].size() == 2);
+        TS_ASSERT(decoded["b"][1].as_int() == 3);
+        try {
+            encoder.end();
+            TS_ASSERT(false);
+        } catch (const domain_error &e) {
+            TS_ASSERT(true);
+        }
+    }
+
+    void test_decode_half_and_strings() {
+        TS_ASSERT(njones::cbor::decode("\xf9\x3c\x00"s).as_double() == 1.0);
+        TS_ASSERT(njones::cbor::decode("\xf9\xc4\x00"s).as_double() == -4.0);
+        TS_ASSERT(njones::cbor::decode("\x7f\x65strea\x64ming\xff"s).as_string() == "streaming");
+        TS_ASSERT(njones::cbor::decode("\xc1\x1a\x51\x4b\x67\xb0"s).as_long() == 1363896240);
+    }
+
+    void test_decode_truncated() {
+        try {
+            njones::cbor::decode("\x83\x01\x02"s);
+            TS_ASSERT(false);
+        } catch (const range_error &e) {
+            TS_ASSERT(true);
+        }
+        try {
+            njones::cbor::decode("\x9b\xff\xff\xff\xff\xff\xff\xff\xff"s);
+            TS_ASSERT(false);
+        } catch (const range_error &e) {
+            TS_ASSERT(true);
+        }
+    }
+};
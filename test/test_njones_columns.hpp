@@ -0,0 +1,72 @@
+#include <cxxtest/TestSuite.h>
+
+#include "dynamic.hpp"
+
+using namespace std;
+
+class columns_test_suite : public CxxTest::TestSuite {
+   public:
+    njones::dynamic make_rows(const int size) {
+        njones::dynamic rows(njones::dynamic::type::ARRAY);
+        for (int i = 0; i < size; i++) {
+            njones::dynamic row;
+            row["id"]    = i;
+            row["score"] = i * 0.5;
+            row["name"]  = "row" + to_string(i);
+            if (i % 3 == 0)
+                row["extra"] = static_cast<long>(i) * 10;
+            rows.push_back(row);
+        }
+        return rows;
+    }
+
+    void test_to_columns() {
+        njones::dynamic rows  = make_rows(100);
+        njones::dynamic table = rows.to_columns();
+        TS_ASSERT(table["size"].as_ulong() == 100);
+
+        njones::dynamic &columns = table["columns"];
+        TS_ASSERT(columns.size() == 4);
+        TS_ASSERT(columns["id"].is_packed());
+        TS_ASSERT(columns["score"].is_packed());
+        TS_ASSERT(columns["extra"].is_packed());
+        TS_ASSERT(!columns["name"].is_packed());
+        TS_ASSERT(columns["id"].sum() == 4950);
+        TS_ASSERT(columns["score"].max() == 49.5);
+        TS_ASSERT(columns["name"][7].as_string() == "row7");
+
+        njones::dynamic &nulls = table["nulls"];
+        TS_ASSERT(nulls.size() == 1);
+        TS_ASSERT(nulls.has("extra"));
+        TS_ASSERT(nulls["extra"].size() == 2);
+        TS_ASSERT((nulls["extra"][0].as_long() & 0x7) == 0x6);
+    }
+
+    void test_from_columns() {
+        njones::dynamic rows = make_rows(5000);
+        njones::dynamic back = njones::dynamic::from_columns(rows.to_columns());
+        TS_ASSERT(back.size() == rows.size());
+        TS_ASSERT(back == rows);
+        TS_ASSERT(back[3]["extra"].is_long());
+        TS_ASSERT(!back[4].has("extra"));
+        TS_ASSERT(back[4]["id"].is_int());
+
+        njones::dynamic table = rows.to_columns();
+        table["columns"]["id"].pop_back();
+        try {
+            njones::dynamic::from_columns(table);
+            TS_ASSERT(false);
+        } catch (const range_error &e) {
+            TS_ASSERT(true);
+        }
+
+        njones::dynamic scalars(njones::dynamic::type::ARRAY);
+        scalars.push_back(1);
+        try {
+            scalars.to_columns();
+            TS_ASSERT(false);
+        } catch (const domain_error &e) {
+            TS_ASSERT(true);
+        }
+    }
+};
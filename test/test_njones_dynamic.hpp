@@ -2,6 +2,8 @@
 #include <cmath>
 #include <limits>
 #include <iostream>
+#include <map>
+#include <thread>
 
 #include "dynamic.hpp"
 
@@ -28,6 +30,12 @@ class dynamic_test_suite : public CxxTest::TestSuite {
         njones::dynamic d(move(original));
         TS_ASSERT(d.as_int() == numeric_limits<int>::max());
         TS_ASSERT(d.get_type() == njones::dynamic::type::INT);
+        TS_ASSERT(original.is_null());
+        original = 5;
+        TS_ASSERT(original.as_int() == 5);
+        TS_ASSERT(d.as_int() == numeric_limits<int>::max());
+        original = "text";
+        TS_ASSERT(original.size() == 4);
     }
 
     void test_null_construction() {
@@ -100,6 +108,11 @@ class dynamic_test_suite : public CxxTest::TestSuite {
         d = move(original);
         TS_ASSERT(d.as_int() == numeric_limits<int>::max());
         TS_ASSERT(d.get_type() == njones::dynamic::type::INT);
+        original = 5;
+        TS_ASSERT(original.as_int() == 5);
+        TS_ASSERT(d.as_int() == numeric_limits<int>::max());
+        original = "text";
+        TS_ASSERT(original.size() == 4);
     }
 
     void test_null_assignment() {
@@ -770,4 +783,622 @@ class dynamic_test_suite : public CxxTest::TestSuite {
         d["key"] = "value";
         TS_ASSERT(d.as_string() == "{\"key\": \"value\"} ");
     }
+
+    void test_hash() {
+        njones::dynamic a(njones::dynamic::type::ARRAY);
+        njones::dynamic map;
+        map["key"] = "value";
+        a.push_back(1);
+        a.push_back(1.5);
+        a.push_back(map);
+        njones::dynamic b = a.deep_copy();
+        TS_ASSERT(a.hash() == b.hash());
+        TS_ASSERT(a == b);
+
+        njones::dynamic nested = b[2];
+        nested["key"]          = "changed";
+        TS_ASSERT(a.hash() != b.hash());
+        TS_ASSERT(a != b);
+
+        nested["key"] = "value";
+        TS_ASSERT(a.hash() == b.hash());
+        TS_ASSERT(a == b);
+
+        njones::dynamic i(1);
+        njones::dynamic l(1L);
+        TS_ASSERT(i.hash() == l.hash());
+        TS_ASSERT(i == l);
+
+        njones::dynamic other;
+        other["key"]          = "other";
+        const size_t before   = a.hash();
+        njones::dynamic value = a[2]["key"];
+        a[2]                  = other;
+        TS_ASSERT(a.hash() != before);
+        TS_ASSERT(a != b);
+
+        a[2] = map;
+        TS_ASSERT(a.hash() == before);
+        value = "changed";
+        TS_ASSERT(a.hash() != before);
+        TS_ASSERT(a[2]["key"] == "changed");
+    }
+
+    void test_hash_shared_subtree() {
+        njones::dynamic shared;
+        shared["key"] = "value";
+        njones::dynamic a, b;
+        a["child"]           = shared;
+        b["child"]           = shared;
+        b["other"]           = 1;
+        const size_t first   = a.hash();
+        const size_t second  = b.hash();
+        njones::dynamic &ref = a["child"]["key"];
+
+        ref = "changed";
+        TS_ASSERT(a.hash() != first);
+        TS_ASSERT(b.hash() != second);
+        ref = "again";
+        ref = "value";
+        TS_ASSERT(a.hash() == first);
+        TS_ASSERT(b.hash() == second);
+
+        const double    values[] = {1.5, 2.5};
+        njones::dynamic packed(njones::dynamic::type::ARRAY);
+        packed.assign(values, 2);
+        const size_t    before = packed.hash();
+        njones::dynamic &item  = packed[0];
+        TS_ASSERT(packed.hash() == before);
+        item = 4.5;
+        TS_ASSERT(packed.hash() != before);
+
+        njones::dynamic map;
+        try {
+            map.push_back(1);
+            TS_ASSERT(false);
+        } catch (const domain_error &e) {
+            TS_ASSERT(string(e.what()).find("array") != string::npos);
+        }
+        njones::dynamic key = njones::dynamic::intern("id");
+        try {
+            key.erase("id");
+            TS_ASSERT(false);
+        } catch (const domain_error &e) {
+            TS_ASSERT(string(e.what()).find("interned") == string::npos);
+        }
+    }
+
+    void test_packed_array() {
+        const double    values[] = {1.5, -2.0, 8.25, 4.0, 0.5, 3.0};
+        njones::dynamic d(njones::dynamic::type::ARRAY);
+        d.assign(values, 6);
+        TS_ASSERT(d.is_packed());
+        TS_ASSERT(d.size() == 6);
+        TS_ASSERT(d.sum() == 15.25);
+        TS_ASSERT(d.min() == -2.0);
+        TS_ASSERT(d.max() == 8.25);
+        TS_ASSERT(d.mean() == 15.25 / 6);
+
+        d.push_back(2.0);
+        TS_ASSERT(d.is_packed());
+        TS_ASSERT(d.size() == 7);
+
+        njones::dynamic generic(njones::dynamic::type::ARRAY);
+        for (const double value : values)
+            generic.push_back(value);
+        generic.push_back(2.0);
+        TS_ASSERT(d.str() == generic.str());
+        TS_ASSERT(d.hash() == generic.hash());
+        TS_ASSERT(d == generic);
+
+        njones::dynamic copy = d.deep_copy();
+        TS_ASSERT(copy.is_packed());
+        TS_ASSERT(d[2].as_double() == 8.25);
+        TS_ASSERT(!d.is_packed());
+        TS_ASSERT(d[2].is_double());
+        TS_ASSERT(copy.sum() == d.sum());
+
+        njones::dynamic reads(njones::dynamic::type::ARRAY);
+        reads.assign(values, 6);
+        const njones::dynamic &view = reads;
+        double                 seen = 0;
+        for (const auto &item : view)
+            seen += item.value().as_double();
+        for (auto iter = view.rbegin(); iter != view.rend(); ++iter)
+            seen -= (*iter).value().as_double();
+        TS_ASSERT(seen == 0);
+        TS_ASSERT(view.element(2).as_double() == 8.25);
+        TS_ASSERT(view.element(2).is_double());
+        TS_ASSERT(view.str() == "[1.5, -2, 8.25, 4, 0.5, 3] ");
+        TS_ASSERT(view.hash() == reads.deep_copy().hash());
+        TS_ASSERT(view.sum() == 15.25);
+        TS_ASSERT(reads.is_packed());
+        reads[0] = 9.0;
+        TS_ASSERT(!reads.is_packed());
+        TS_ASSERT(view.element(0).as_double() == 9.0);
+        TS_ASSERT(view.sum() == 22.75);
+
+        njones::dynamic ints(njones::dynamic::type::ARRAY);
+        ints.push_back(3);
+        ints.push_back(-7);
+        ints.push_back(11);
+        TS_ASSERT(ints.pack());
+        TS_ASSERT(ints.is_packed());
+        TS_ASSERT(ints.sum() == 7);
+        TS_ASSERT(ints.min() == -7);
+        TS_ASSERT(ints.str() == "[3, -7, 11] ");
+        ints.push_back(1.5);
+        TS_ASSERT(!ints.is_packed());
+        TS_ASSERT(ints[0].is_int());
+        TS_ASSERT(!ints.pack());
+
+        const long      large[] = {(1L << 53) + 1, 1, -(1L << 53), 4, -3};
+        njones::dynamic longs(njones::dynamic::type::ARRAY);
+        longs.assign(large, 5);
+        TS_ASSERT(longs.is_packed());
+        TS_ASSERT(longs.sum() == 3);
+
+        const double nan       = numeric_limits<double>::quiet_NaN();
+        const double skipped[] = {4.0, nan, 2.5, -1.0, nan, 9.0, 3.0, nan, 0.5};
+        const double leading[] = {nan, 4.0, 2.5, -1.0, 9.0, 3.0, 0.5, 1.0};
+        for (const double *series : {skipped, leading}) {
+            const size_t    count = series == skipped ? 9 : 8;
+            njones::dynamic fast(njones::dynamic::type::ARRAY);
+            njones::dynamic slow(njones::dynamic::type::ARRAY);
+            fast.assign(series, count);
+            for (size_t i = 0; i < count; i++)
+                slow.push_back(series[i]);
+            TS_ASSERT(fast.is_packed());
+            TS_ASSERT(!slow.is_packed());
+            TS_ASSERT(std::isnan(fast.min()) == std::isnan(slow.min()));
+            TS_ASSERT(std::isnan(fast.max()) == std::isnan(slow.max()));
+            TS_ASSERT(std::isnan(fast.min()) || fast.min() == slow.min());
+            TS_ASSERT(std::isnan(fast.max()) || fast.max() == slow.max());
+        }
+
+        njones::dynamic empty(njones::dynamic::type::ARRAY);
+        TS_ASSERT(empty.sum() == 0);
+        try {
+            empty.min();
+            TS_ASSERT(false);
+        } catch (const range_error &e) {
+            TS_ASSERT(true);
+        }
+    }
+
+    void test_shaped_map() {
+        njones::dynamic a;
+        njones::dynamic b;
+        a["id"]   = 1;
+        a["name"] = "first";
+        b["id"]   = 2;
+        b["name"] = "second";
+        TS_ASSERT(a.str() == "{\"id\": 1, \"name\": \"first\"} ");
+
+        auto iter = b.begin();
+        TS_ASSERT((*iter).key().as_string() == "id");
+        ++iter;
+        TS_ASSERT((*iter).value().as_string() == "second");
+        --iter;
+        TS_ASSERT((*iter).value().as_int() == 2);
+
+        njones::dynamic reordered;
+        reordered["name"] = "first";
+        reordered["id"]   = 1;
+        TS_ASSERT(a == reordered);
+        TS_ASSERT(a.hash() == reordered.hash());
+
+        b.erase("id");
+        TS_ASSERT(b.size() == 1);
+        TS_ASSERT(!b.has("id"));
+        TS_ASSERT(a.has("id"));
+        b["id"] = 3;
+        TS_ASSERT(b["id"].as_int() == 3);
+
+        njones::dynamic wide;
+        for (int i = 0; i < 100; i++)
+            wide[i] = i;
+        TS_ASSERT(wide.size() == 100);
+        TS_ASSERT(wide[42].as_int() == 42);
+        njones::dynamic copy = wide.deep_copy();
+        TS_ASSERT(copy == wide);
+
+        a.clear();
+        TS_ASSERT(a.empty());
+        a["name"] = "again";
+        TS_ASSERT(a.size() == 1);
+
+        njones::dynamic  held;
+        njones::dynamic &first = held["first"];
+        for (int i = 0; i < 200; i++)
+            held[std::to_string(i)] = i;
+        for (int i = 0; i < 190; i++)
+            held.erase(std::to_string(i));
+        first = "kept";
+        TS_ASSERT(held["first"].as_string() == "kept");
+        held["copy"] = held["fresh"];
+        TS_ASSERT(held["copy"].is_map());
+        TS_ASSERT(held.size() == 13);
+        njones::dynamic cloned = held.deep_copy();
+        TS_ASSERT(cloned == held);
+    }
+
+    void test_interned_keys() {
+        static const njones::dynamic ID = njones::dynamic::intern("id");
+        TS_ASSERT(ID.is_interned());
+        TS_ASSERT(njones::dynamic::intern("id") == ID);
+        TS_ASSERT(njones::dynamic::intern("id").hash() == ID.hash());
+        TS_ASSERT(njones::dynamic::intern("name") != ID);
+        TS_ASSERT(njones::dynamic("id") == ID);
+
+        njones::dynamic record;
+        record["id"] = 7;
+        TS_ASSERT((*record.begin()).key().is_interned());
+        TS_ASSERT(record[ID].as_int() == 7);
+
+        njones::dynamic big;
+        for (int i = 0; i < 100; i++)
+            big[std::to_string(i)] = i;
+        TS_ASSERT(big[ID].is_map());
+        TS_ASSERT(big.size() == 101);
+
+        njones::dynamic other;
+        other["type"] = njones::dynamic::intern("event");
+        other["type"] = "changed";
+        TS_ASSERT(other["type"].as_string() == "changed");
+        TS_ASSERT(njones::dynamic::intern("event").as_string() == "event");
+
+        njones::dynamic key = njones::dynamic::intern("id");
+        try {
+            key.resize(1);
+            TS_ASSERT(false);
+        } catch (const domain_error &e) {
+            TS_ASSERT(true);
+        }
+    }
+
+    void test_concurrent_map() {
+        njones::dynamic cache = njones::dynamic::concurrent(4);
+        TS_ASSERT(cache.is_concurrent());
+        TS_ASSERT(cache.is_map());
+        TS_ASSERT(cache.empty());
+        TS_ASSERT(cache.begin() == cache.end());
+
+        std::vector<std::thread> writers;
+        for (int t = 0; t < 4; t++)
+            writers.emplace_back([&cache, t]() {
+                for (int i = 0; i < 500; i++) {
+                    cache.insert_or_assign(std::to_string(t * 500 + i), i);
+                    cache.compute_if_absent("shared", [t]() { return njones::dynamic(t); });
+                    if (i % 2 == 1)
+                        cache.erase(std::to_string(t * 500 + i - 1));
+                }
+            });
+        for (auto &w : writers)
+            w.join();
+
+        TS_ASSERT(cache.size() == 1001);
+        size_t count = 0;
+        for (const auto item : cache)
+            count += item.key() == "shared" || item.value().as_int() % 2 == 1;
+        TS_ASSERT(count == 1001);
+
+        njones::dynamic value;
+        TS_ASSERT(cache.find("1999", value));
+        TS_ASSERT(value.as_int() == 499);
+        TS_ASSERT(!cache.find("1998", value));
+        TS_ASSERT(cache.compute_if_absent("1999", []() { return njones::dynamic(0); }) == 499);
+        TS_ASSERT(cache.has("shared"));
+
+        njones::dynamic copy = cache.deep_copy();
+        TS_ASSERT(copy.is_concurrent());
+        TS_ASSERT(copy == cache);
+
+        njones::dynamic small = njones::dynamic::concurrent();
+        small["a"]            = 1;
+        TS_ASSERT(small.str() == "{\"a\": 1} ");
+        small.clear();
+        TS_ASSERT(small.empty());
+
+        njones::dynamic plain;
+        plain.insert_or_assign("a", 1);
+        plain.insert_or_assign("a", 2);
+        TS_ASSERT(plain["a"].as_int() == 2);
+        TS_ASSERT(!plain.is_concurrent());
+
+        try {
+            njones::dynamic::concurrent(0);
+            TS_ASSERT(false);
+        } catch (const domain_error &e) {
+            TS_ASSERT(true);
+        }
+    }
+
+    void test_memoized_str() {
+        njones::dynamic doc;
+        doc["status"] = "ok";
+        doc["items"]  = njones::dynamic(njones::dynamic::type::ARRAY);
+        for (int i = 0; i < 50; i++) {
+            njones::dynamic item;
+            item["id"]        = i;
+            item["tags"]      = njones::dynamic(njones::dynamic::type::ARRAY);
+            item["meta"]["x"] = i * 0.5;
+            doc["items"].push_back(item);
+        }
+        doc.memoize();
+        TS_ASSERT(doc.is_memoized());
+
+        auto check = [&doc]() {
+            njones::dynamic plain = doc.deep_copy();
+            TS_ASSERT(!plain.is_memoized());
+            for (const bool pretty : {false, true}) {
+                TS_ASSERT(doc.str(pretty) == plain.str(pretty));
+                TS_ASSERT(doc.str(pretty) == plain.str(pretty));
+            }
+        };
+
+        check();
+        doc["items"][3]["meta"]["x"] = "changed";
+        check();
+        njones::dynamic &leaf = doc["items"][7]["id"];
+        leaf                  = 700;
+        check();
+        njones::dynamic replacement;
+        replacement["new"] = true;
+        doc["items"][9]    = replacement;
+        check();
+        replacement["added"] = 1;
+        check();
+        doc["items"][11]["tags"].push_back("tag");
+        check();
+        doc["items"].pop_back();
+        check();
+        doc["items"][13].erase("meta");
+        check();
+        doc["items"][14].set_type(njones::dynamic::type::ARRAY);
+        check();
+        doc["status"] = njones::dynamic::intern("ok");
+        check();
+        njones::dynamic shared = doc["items"][16];
+        doc["items"][15]       = shared;
+        check();
+        shared["id"] = "shared";
+        check();
+
+        doc.memoize(false);
+        TS_ASSERT(!doc.is_memoized());
+        check();
+    }
+
+    void test_canonical() {
+        njones::dynamic a;
+        a["b"]      = 1;
+        a["a"]      = "x\ty\u0001\"\\/\xc3\xa9";
+        a["c"]["z"] = 1e21;
+        a["c"]["y"] = 0.1;
+        a["c"]["x"] = -1.5e-7;
+        a["c"]["w"] = 100.0;
+        a["c"]["v"] = 123456789012.0;
+        a["d"]      = njones::dynamic(njones::dynamic::type::ARRAY);
+
+        a["\xef\xbc\xa1"]     = true;
+        a["\xf0\x9f\x98\x80"] = nullptr;
+        a["d"].push_back(2);
+        a["d"].push_back(0.5);
+        a["d"].push_back(-0.0);
+        const std::string expected =
+            "{\"a\":\"x\\ty\\u0001\\\"\\\\/\xc3\xa9\",\"b\":1,"
+            "\"c\":{\"v\":123456789012,\"w\":100,\"x\":-1.5e-7,\"y\":0.1,\"z\":1e+21},"
+            "\"d\":[2,0.5,0],\"\xf0\x9f\x98\x80\":null,\"\xef\xbc\xa1\":true}";
+        TS_ASSERT_EQUALS(a.canonical(), expected);
+
+        njones::dynamic b = njones::dynamic::concurrent(4);
+        b["d"] = a["d"];
+        b["c"] = a["c"];
+        for (auto key : {"\xf0\x9f\x98\x80", "\xef\xbc\xa1", "b", "a"})
+            b[key] = a[key];
+        TS_ASSERT_EQUALS(b.canonical(), expected);
+
+        njones::dynamic packed(njones::dynamic::type::ARRAY);
+        const double values[] = {1.0, 2.5, 1e-7};
+        packed.assign(values, 3);
+        packed.pack();
+        TS_ASSERT_EQUALS(packed.canonical(), "[1,2.5,1e-7]");
+
+        njones::dynamic bad;
+        bad[1] = "x";
+        try {
+            bad.canonical();
+            TS_ASSERT(false);
+        } catch (const domain_error &e) {
+            TS_ASSERT(true);
+        }
+        try {
+            njones::dynamic(std::numeric_limits<double>::infinity()).canonical();
+            TS_ASSERT(false);
+        } catch (const domain_error &e) {
+            TS_ASSERT(true);
+        }
+    }
+
+    void test_ordered_map() {
+        njones::dynamic m = njones::dynamic::ordered();
+        TS_ASSERT(m.is_ordered());
+        TS_ASSERT(!njones::dynamic().is_ordered());
+        TS_ASSERT(!njones::dynamic::concurrent().is_ordered());
+        TS_ASSERT(m.begin() == m.end());
+
+        std::vector<int> keys;
+        for (int i = 0; i < 200; i++)
+            keys.push_back((i * 73) % 200);
+        for (const int k : keys)
+            m[k] = k * 2;
+        TS_ASSERT_EQUALS(m.size(), 200);
+
+        size_t i = 0;
+        for (auto item : m) {
+            TS_ASSERT(item.key() == keys[i]);
+            TS_ASSERT(item.value() == keys[i] * 2);
+            i++;
+        }
+        TS_ASSERT_EQUALS(i, 200);
+
+        m[keys[5]] = "changed";
+        TS_ASSERT((*(++m.begin())).key() == keys[1]);
+        for (size_t j = 0; j < keys.size(); j += 3)
+            m.erase(keys[j]);
+        for (size_t j = 1; j < keys.size(); j += 3)
+            m.erase(keys[j]);
+        m.erase(-1);
+        m[keys[0]] = true;
+        TS_ASSERT_EQUALS(m.size(), 67);
+        TS_ASSERT(m.has(keys[2]));
+        TS_ASSERT(!m.has(keys[3]));
+        TS_ASSERT(m[keys[5]] == "changed");
+
+        std::vector<njones::dynamic> expected;
+        for (size_t j = 2; j < keys.size(); j += 3)
+            expected.push_back(keys[j]);
+        expected.push_back(keys[0]);
+        const njones::dynamic copy = m.deep_copy();
+        TS_ASSERT(copy.is_ordered());
+        TS_ASSERT(copy == m);
+        i = 0;
+        for (auto item : copy)
+            TS_ASSERT(item.key() == expected[i++]);
+        TS_ASSERT_EQUALS(i, expected.size());
+
+        njones::dynamic small = njones::dynamic::ordered();
+        small["z"] = 1;
+        small["a"] = 2;
+        small["m"] = 3;
+        small.erase("a");
+        small["a"] = 4;
+        TS_ASSERT_EQUALS(small.str(), "{\"z\": 1, \"m\": 3, \"a\": 4} ");
+
+        small.clear();
+        TS_ASSERT(small.empty());
+        TS_ASSERT(small.is_ordered());
+        small["b"] = 1;
+        TS_ASSERT_EQUALS(small.str(), "{\"b\": 1} ");
+
+        njones::dynamic  held  = njones::dynamic::ordered();
+        njones::dynamic &first = held["first"];
+        for (int i = 0; i < 200; i++)
+            held[std::to_string(i)] = i;
+        for (int i = 0; i < 190; i++)
+            held.erase(std::to_string(i));
+        first = "kept";
+        TS_ASSERT(held["first"].as_string() == "kept");
+        held["copy"] = held["fresh"];
+        TS_ASSERT(held["copy"].is_map());
+        TS_ASSERT_EQUALS(held.size(), 13u);
+    }
+
+    void test_map_erase() {
+        njones::dynamic m;
+        m["a"] = 1;
+        m["b"] = 2;
+        m["c"] = 3;
+        m["d"] = 4;
+        m.erase("a");
+        TS_ASSERT(!m.is_ordered());
+        TS_ASSERT_EQUALS(m.str(), "{\"d\": 4, \"b\": 2, \"c\": 3} ");
+
+        njones::dynamic ordered = njones::dynamic::ordered();
+        for (const char *key : {"a", "b", "c", "d"})
+            ordered[key] = 0;
+        ordered.erase("a");
+        TS_ASSERT_EQUALS(ordered.str(), "{\"b\": 0, \"c\": 0, \"d\": 0} ");
+
+        std::map<int, int> expected;
+        njones::dynamic    big;
+        unsigned int       seed = 7;
+        for (int round = 0; round < 20000; round++) {
+            seed           = seed * 1103515245 + 12345;
+            const int  key = static_cast<int>((seed >> 8) % 512);
+            const bool add = (seed >> 20) % 3 != 0;
+            if (add) {
+                big[key]      = round;
+                expected[key] = round;
+            } else {
+                big.erase(key);
+                expected.erase(key);
+            }
+        }
+        TS_ASSERT_EQUALS(big.size(), expected.size());
+        for (int key = 0; key < 512; key++) {
+            TS_ASSERT_EQUALS(big.has(key), expected.count(key) == 1);
+            if (expected.count(key) == 1)
+                TS_ASSERT_EQUALS(big[key].as_int(), expected[key]);
+        }
+        size_t seen = 0;
+        for (auto item : big) {
+            TS_ASSERT_EQUALS(item.value().as_int(), expected[item.key().as_int()]);
+            seen++;
+        }
+        TS_ASSERT_EQUALS(seen, expected.size());
+    }
+
+    void test_map_reverse_iteration() {
+        for (const int count : {0, 5, 100}) {
+            njones::dynamic m;
+            for (int i = 0; i < count; i++)
+                m[i] = i * 10;
+            if (count > 0)
+                m.erase(count / 2);
+
+            std::vector<int> forward;
+            for (auto item : m)
+                forward.push_back(item.key().as_int());
+
+            std::vector<int> backward;
+            for (auto iter = m.rbegin(); iter != m.rend(); ++iter) {
+                TS_ASSERT((*iter).value() == (*iter).key().as_int() * 10);
+                backward.insert(backward.begin(), (*iter).key().as_int());
+            }
+            TS_ASSERT(forward == backward);
+
+            const njones::dynamic &c = m;
+            backward.clear();
+            for (auto iter = c.crbegin(); iter != c.crend(); iter++)
+                backward.insert(backward.begin(), (*iter).key().as_int());
+            TS_ASSERT(forward == backward);
+
+            if (count == 0)
+                continue;
+            auto iter = m.end();
+            --iter;
+            TS_ASSERT((*iter).key() == forward.back());
+            iter--;
+            TS_ASSERT((*iter).key() == forward[forward.size() - 2]);
+            ++iter;
+            TS_ASSERT((*iter).key() == forward.back());
+
+            auto first = c.begin();
+            TS_ASSERT(&(*first).key() == &(*c.begin()).key());
+        }
+
+        njones::dynamic a(njones::dynamic::type::ARRAY);
+        a.push_back(1);
+        a.push_back(2);
+        TS_ASSERT((*a.rbegin()).value() == 2);
+        TS_ASSERT((*a.begin()).key() == "");
+
+        njones::dynamic concurrent = njones::dynamic::concurrent();
+        concurrent["a"]            = 1;
+        try {
+            concurrent.rbegin();
+            TS_ASSERT(false);
+        } catch (const domain_error &e) {
+            TS_ASSERT(true);
+        }
+        try {
+            auto iter = concurrent.end();
+            --iter;
+            TS_ASSERT(false);
+        } catch (const domain_error &e) {
+            TS_ASSERT(true);
+        }
+    }
 };
@@ -0,0 +1,91 @@
+#include <cxxtest/TestSuite.h>
+#include <limits>
+#include <thread>
+#include <vector>
+
+#include "dynamic.hpp"
+#include "frozen.hpp"
+
+using namespace std;
+
+class frozen_test_suite : public CxxTest::TestSuite {
+   public:
+    njones::dynamic make_document() {
+        njones::dynamic d;
+        d["int"]    = -42;
+        d["ulong"]  = numeric_limits<unsigned long>::max();
+        d["double"] = 1.25;
+        d["bool"]   = true;
+        d["null"]   = nullptr;
+        d["string"] = "a string";
+        d["array"].set_type(njones::dynamic::type::ARRAY);
+        d["array"].push_back(1);
+        d["array"].push_back("two");
+        d["array"].push_back(3.5);
+        for (int i = 0; i < 20; i++)
+            d["wide"]["key" + to_string(i)] = i;
+        return d;
+    }
+
+    void test_frozen_access() {
+        const njones::frozen_document doc  = make_document().freeze();
+        const njones::frozen_value    root = doc.root();
+        TS_ASSERT(root.is_map());
+        TS_ASSERT(root.size() == 8);
+        TS_ASSERT(root["int"].as_int() == -42);
+        TS_ASSERT(root["ulong"].as_ulong() == numeric_limits<unsigned long>::max());
+        TS_ASSERT(root["double"].as_double() == 1.25);
+        TS_ASSERT(root["bool"].as_bool());
+        TS_ASSERT(root["null"].is_null());
+        TS_ASSERT(root["string"].as_string() == "a string");
+        TS_ASSERT(doc["array"].size() == 3);
+        TS_ASSERT(doc["array"][1].as_string() == "two");
+        TS_ASSERT(doc["array"].back().as_double() == 3.5);
+        TS_ASSERT(doc["wide"]["key17"].as_int() == 17);
+        TS_ASSERT(!doc["wide"].has("key20"));
+        TS_ASSERT(doc["wide"].has("key0"));
+
+        try {
+            doc["missing"];
+            TS_ASSERT(false);
+        } catch (const range_error &e) {
+            TS_ASSERT(true);
+        }
+        try {
+            doc["array"][3];
+            TS_ASSERT(false);
+        } catch (const range_error &e) {
+            TS_ASSERT(true);
+        }
+    }
+
+    void test_frozen_iteration() {
+        const njones::frozen_document doc = make_document().freeze();
+        int                           sum = 0;
+        for (const auto item : doc["wide"]) {
+            TS_ASSERT(item.key().as_string() == "key" + to_string(item.value().as_int()));
+            sum += item.value().as_int();
+        }
+        TS_ASSERT(sum == 190);
+
+        auto iter = doc["array"].end();
+        --iter;
+        TS_ASSERT((*iter).value().as_double() == 3.5);
+        TS_ASSERT(doc.to_dynamic() == make_document());
+    }
+
+    void test_frozen_threads() {
+        const njones::frozen_document doc = make_document().freeze();
+        vector<long>                  sums(4, 0);
+        vector<thread>                threads;
+        for (size_t t = 0; t < sums.size(); t++)
+            threads.emplace_back([&doc, &sums, t] {
+                for (int i = 0; i < 1000; i++)
+                    sums[t] += doc["wide"]["key" + to_string(i % 20)].as_long();
+            });
+        for (thread &t : threads)
+            t.join();
+        for (const long sum : sums)
+            TS_ASSERT(sum == 9500);
+    }
+};
@@ -0,0 +1,121 @@
+#include <cxxtest/TestSuite.h>
+#include <vector>
+
+#include "dynamic.hpp"
+#include "jsonpath.hpp"
+
+using namespace std;
+
+class jsonpath_test_suite : public CxxTest::TestSuite {
+   public:
+    njones::dynamic make_document() {
+        njones::dynamic d;
+        d["orders"].set_type(njones::dynamic::type::ARRAY);
+        const int totals[] = {50, 150, 9, 100, 1000};
+        for (int i = 0; i < 5; i++) {
+            njones::dynamic order;
+            order["id"]    = i;
+            order["total"] = totals[i];
+            order["tags"].set_type(njones::dynamic::type::ARRAY);
+            order["tags"].push_back(i % 2 == 0 ? "even" : "odd");
+            d["orders"].push_back(order);
+        }
+        d["orders"][1]["total"] = 150.5;
+        d["store"]["name"]      = "shop";
+        d["store"]["limit"]     = 100;
+        return d;
+    }
+
+    void test_child_and_index() {
+        njones::dynamic d = make_document();
+        auto            r = njones::jsonpath("$.store.name").evaluate(d);
+        TS_ASSERT(r.size() == 1);
+        TS_ASSERT(r[0] == &d["store"]["name"]);
+        r = njones::jsonpath("$['store']['limit']").evaluate(d);
+        TS_ASSERT(r.size() == 1 && r[0]->as_int() == 100);
+        r = njones::jsonpath("$.orders[-1].id").evaluate(d);
+        TS_ASSERT(r.size() == 1 && r[0]->as_int() == 4);
+        r = njones::jsonpath("$.orders[0,2].id").evaluate(d);
+        TS_ASSERT(r.size() == 2 && r[1]->as_int() == 2);
+        r = njones::jsonpath("$.orders[1:4:2].id").evaluate(d);
+        TS_ASSERT(r.size() == 2 && r[0]->as_int() == 1 && r[1]->as_int() == 3);
+        r = njones::jsonpath("$.orders[::-1].id").evaluate(d);
+        TS_ASSERT(r.size() == 5 && r[0]->as_int() == 4);
+        r = njones::jsonpath("$.missing.name").evaluate(d);
+        TS_ASSERT(r.empty());
+    }
+
+    void test_wildcard_and_descent() {
+        njones::dynamic d = make_document();
+        TS_ASSERT(njones::jsonpath("$.orders[*].id").evaluate(d).size() == 5);
+        TS_ASSERT(njones::jsonpath("$.store.*").evaluate(d).size() == 2);
+        TS_ASSERT(njones::jsonpath("$..id").evaluate(d).size() == 5);
+        TS_ASSERT(njones::jsonpath("$..tags[0]").evaluate(d).size() == 5);
+    }
+
+    void test_filter_numeric() {
+        njones::dynamic d = make_document();
+        auto            r = njones::jsonpath("$.orders[?(@.total > 100)].id").evaluate(d);
+        TS_ASSERT(r.size() == 2);
+        TS_ASSERT(r[0]->as_int() == 1);
+        TS_ASSERT(r[1]->as_int() == 4);
+        r = njones::jsonpath("$.orders[?(@.total >= $.store.limit)].id").evaluate(d);
+        TS_ASSERT(r.size() == 3);
+        r = njones::jsonpath("$.orders[?(@.total < 100 && @.tags[0] == 'even')].id").evaluate(d);
+        TS_ASSERT(r.size() == 2);
+        r = njones::jsonpath("$.orders[?(!(@.id == 0) || @.total == 50)]").evaluate(d);
+        TS_ASSERT(r.size() == 5);
+        r = njones::jsonpath("$.orders[?(@.missing)]").evaluate(d);
+        TS_ASSERT(r.empty());
+        r = njones::jsonpath("$.orders[?(@.total == 150.5)].id").evaluate(d);
+        TS_ASSERT(r.size() == 1 && r[0]->as_int() == 1);
+    }
+
+    void test_references() {
+        njones::dynamic d = make_document();
+        for (njones::dynamic *total : njones::jsonpath("$.orders[*].total").evaluate(d))
+            *total = 0;
+        TS_ASSERT(d["orders"][4]["total"].as_int() == 0);
+    }
+
+    void test_parallel() {
+        njones::dynamic d;
+        d["orders"].set_type(njones::dynamic::type::ARRAY);
+        for (int i = 0; i < 10000; i++) {
+            njones::dynamic order;
+            order["id"]    = i;
+            order["total"] = i % 200;
+            d["orders"].push_back(order);
+        }
+        njones::jsonpath path("$.orders[?(@.total > 100)].id");
+        auto             serial   = path.evaluate(d);
+        auto             parallel = path.evaluate(d, 4);
+        TS_ASSERT(serial.size() == 4950);
+        TS_ASSERT(serial == parallel);
+    }
+
+    void test_invalid() {
+        try {
+            njones::jsonpath("orders");
+            TS_ASSERT(false);
+        } catch (const domain_error &e) {
+            TS_ASSERT(true);
+        }
+        try {
+            njones::jsonpath("$.orders[?(@.total > )]");
+            TS_ASSERT(false);
+        } catch (const domain_error &e) {
+            TS_ASSERT(true);
+        }
+        for (const char *literal : {"0x10", "inf", "nan", "+1", "1.", ".5", "1e"}) {
+            try {
+                njones::jsonpath(string("$.orders[?(@.total > ") + literal + ")]");
+                TS_ASSERT(false);
+            } catch (const domain_error &e) {
+                TS_ASSERT(true);
+            }
+        }
+        njones::dynamic d = make_document();
+        TS_ASSERT(njones::jsonpath("$.orders[?(@.total > -1.5e2)]").evaluate(d).size() == 5);
+    }
+};
@@ -0,0 +1,138 @@
+#include <cxxtest/TestSuite.h>
+#include <atomic>
+
+#include "dynamic.hpp"
+#include "parallel.hpp"
+#include "stream.hpp"
+
+using namespace std;
+
+class parallel_test_suite : public CxxTest::TestSuite {
+   public:
+    njones::dynamic make_array(const int size) {
+        njones::dynamic d(njones::dynamic::type::ARRAY);
+        for (int i = 0; i < size; i++)
+            d.push_back((i * 7919) % size);
+        return d;
+    }
+
+    void test_for_each() {
+        njones::dynamic          d = make_array(10000);
+        njones::parallel_options options;
+        options.grain = 100;
+        njones::parallel::for_each(d, [](njones::dynamic &item) { item = item.as_int() * 2; },
+                                   options);
+        TS_ASSERT(d[1].as_int() == (7919 % 10000) * 2);
+        TS_ASSERT(d.size() == 10000);
+    }
+
+    void test_transform_filter() {
+        njones::dynamic          d = make_array(10000);
+        njones::parallel_options options;
+        options.grain   = 64;
+        options.threads = 3;
+        njones::dynamic squares =
+            njones::parallel::transform(d, [](const njones::dynamic &item) -> njones::dynamic {
+                return static_cast<long>(item.as_int()) * item.as_int();
+            }, options);
+        TS_ASSERT(squares.size() == d.size());
+        TS_ASSERT(squares[3].as_long() == static_cast<long>(d[3].as_int()) * d[3].as_int());
+
+        njones::dynamic even = njones::parallel::filter(
+            d, [](const njones::dynamic &item) { return item.as_int() % 2 == 0; }, options);
+        TS_ASSERT(even.size() == 5000);
+        for (size_t i = 1; i < 20; i++)
+            TS_ASSERT(even[i].as_int() % 2 == 0);
+    }
+
+    void test_reduce() {
+        njones::dynamic          d = make_array(10000);
+        njones::parallel_options options;
+        options.grain       = 128;
+        njones::dynamic sum = njones::parallel::reduce(
+            d, 0L,
+            [](const njones::dynamic &a, const njones::dynamic &b) -> njones::dynamic {
+                return a.as_long() + b.as_long();
+            },
+            options);
+        TS_ASSERT(sum.as_long() == 49995000L);
+    }
+
+    void test_sort() {
+        njones::dynamic          d = make_array(10000);
+        njones::parallel_options options;
+        options.grain = 256;
+        njones::parallel::sort(
+            d,
+            [](const njones::dynamic &a, const njones::dynamic &b) {
+                return a.as_int() < b.as_int();
+            },
+            options);
+        for (size_t i = 0; i < d.size(); i++)
+            TS_ASSERT(d[i].as_int() == static_cast<int>(i));
+    }
+
+    void test_exception() {
+        njones::dynamic d = make_array(1000);
+        try {
+            njones::parallel::for_each(d, [](njones::dynamic &item) {
+                if (item.as_int() == 500)
+                    throw range_error("found");
+            });
+            TS_ASSERT(false);
+        } catch (const range_error &e) {
+            TS_ASSERT(true);
+        }
+    }
+
+    void test_nested() {
+        njones::thread_pool pool(2);
+        atomic<int>         count(0);
+        pool.run(8, 3, [&pool, &count](const size_t) {
+            pool.run(4, 3, [&count](const size_t) { count++; });
+        });
+        TS_ASSERT(count == 32);
+    }
+
+    void test_str() {
+        njones::dynamic doc;
+        doc["name"] = "parallel";
+        doc["ids"]  = make_array(5000);
+        doc["ids"].pack();
+        doc["rows"] = njones::dynamic(njones::dynamic::type::ARRAY);
+        for (int i = 0; i < 300; i++) {
+            njones::dynamic row;
+            row["id"]    = i;
+            row["tags"]  = make_array(i % 5);
+            row["empty"] = njones::dynamic(njones::dynamic::type::ARRAY);
+            row["child"]["value"] = i * 0.5;
+            doc["rows"].push_back(row);
+        }
+        doc["nested"]["deeper"]["rows"] = doc["rows"];
+
+        njones::parallel_options options;
+        options.grain   = 16;
+        options.threads = 4;
+        for (const bool pretty : {false, true}) {
+            TS_ASSERT(njones::parallel::str(doc, pretty, options) == doc.str(pretty));
+            TS_ASSERT(njones::parallel::str(doc["rows"], pretty, options) ==
+                      doc["rows"].str(pretty));
+            TS_ASSERT(njones::parallel::str(doc["ids"], pretty, options) ==
+                      doc["ids"].str(pretty));
+            TS_ASSERT(njones::parallel::str(doc["name"], pretty, options) ==
+                      doc["name"].str(pretty));
+
+            std::ostringstream s;
+            njones::parallel::write(doc, s, pretty, options);
+            TS_ASSERT(s.str() == doc.str(pretty));
+
+            std::string         streamed;
+            njones::string_sink sink(streamed);
+            {
+                njones::dynamic_stream out(sink, 64);
+                njones::parallel::write(doc, out, pretty, options);
+            }
+            TS_ASSERT(streamed == doc.str(pretty));
+        }
+    }
+};
@@ -0,0 +1,238 @@
+#include <cxxtest/TestSuite.h>
+
+#include "dynamic.hpp"
+
+using namespace std;
+
+class patch_test_suite : public CxxTest::TestSuite {
+   public:
+    njones::dynamic make_document() {
+        njones::dynamic d;
+        d["name"]  = "widget";
+        d["count"] = 3;
+        d["tags"].set_type(njones::dynamic::type::ARRAY);
+        d["tags"].push_back("a");
+        d["tags"].push_back("b");
+        d["tags"].push_back("c");
+        d["nested"]["a/b"] = 1;
+        d["nested"]["c~d"] = 2;
+        return d;
+    }
+
+    void test_diff_identical() {
+        njones::dynamic a = make_document();
+        TS_ASSERT(njones::dynamic::diff(a, a).empty());
+        TS_ASSERT(njones::dynamic::diff(a, a.deep_copy()).empty());
+    }
+
+    void test_diff_round_trip() {
+        njones::dynamic a = make_document();
+        njones::dynamic b = a.deep_copy();
+        b["count"]         = 4L;
+        b["added"]         = true;
+        b.erase("name");
+        b["nested"]["a/b"] = "changed";
+        b["tags"].pop_back();
+        b["tags"].push_back("d");
+
+        njones::dynamic patch = njones::dynamic::diff(a, b);
+        TS_ASSERT(patch.size() == 5);
+        a.apply_patch(patch);
+        TS_ASSERT(njones::dynamic::diff(a, b).empty());
+        TS_ASSERT(a["nested"]["a/b"].as_string() == "changed");
+        TS_ASSERT(a["tags"][2].as_string() == "d");
+    }
+
+    void test_diff_copies_values() {
+        njones::dynamic a = make_document();
+        njones::dynamic b = a.deep_copy();
+        b["added"]["x"]   = 1;
+        b["tags"].push_back(b["added"]);
+        b["nested"]       = "scalar";
+        b["name"]         = b["added"];
+
+        njones::dynamic patch = njones::dynamic::diff(a, b);
+        b["added"]["x"]       = 2;
+        for (const auto item : patch)
+            if (item.value()["value"].is_map())
+                TS_ASSERT(item.value()["value"]["x"].as_int() == 1);
+        a.apply_patch(patch);
+        TS_ASSERT(a["added"]["x"].as_int() == 1);
+        TS_ASSERT(a["tags"][3]["x"].as_int() == 1);
+        TS_ASSERT(a["name"]["x"].as_int() == 1);
+    }
+
+    void test_diff_arrays() {
+        njones::dynamic a(njones::dynamic::type::ARRAY);
+        a.push_back(1);
+        a.push_back(2);
+        a.push_back(3);
+        njones::dynamic b(njones::dynamic::type::ARRAY);
+        b.push_back(1);
+        b.push_back(9);
+        b.push_back(2);
+        b.push_back(3);
+
+        njones::dynamic patch = njones::dynamic::diff(a, b);
+        TS_ASSERT(patch.size() == 1);
+        TS_ASSERT(patch[0]["op"].as_string() == "add");
+        TS_ASSERT(patch[0]["path"].as_string() == "/1");
+
+        a.apply_patch(patch);
+        TS_ASSERT(a == b);
+
+        njones::dynamic empty(njones::dynamic::type::ARRAY);
+        njones::dynamic back = njones::dynamic::diff(b, empty);
+        TS_ASSERT(back.size() == 4);
+        b.apply_patch(back);
+        TS_ASSERT(b.empty());
+    }
+
+    void test_diff_typed() {
+        njones::dynamic a;
+        njones::dynamic b;
+        a["value"] = 1;
+        b["value"] = 1L;
+        njones::dynamic patch = njones::dynamic::diff(a, b);
+        TS_ASSERT(patch.size() == 1);
+        TS_ASSERT(patch[0]["op"].as_string() == "replace");
+        a.apply_patch(patch);
+        TS_ASSERT(a["value"].is_long());
+    }
+
+    void test_apply_operations() {
+        njones::dynamic d = make_document();
+        njones::dynamic patch(njones::dynamic::type::ARRAY);
+        njones::dynamic op;
+
+        op["op"]    = "add";
+        op["path"]  = "/tags/0";
+        op["value"] = "first";
+        patch.push_back(op);
+
+        op          = njones::dynamic();
+        op["op"]    = "replace";
+        op["path"]  = "/nested/a~1b";
+        op["value"] = 5;
+        patch.push_back(op);
+
+        op         = njones::dynamic();
+        op["op"]   = "move";
+        op["from"] = "/name";
+        op["path"] = "/title";
+        patch.push_back(op);
+
+        op         = njones::dynamic();
+        op["op"]   = "copy";
+        op["from"] = "/count";
+        op["path"] = "/tags/-";
+        patch.push_back(op);
+
+        op         = njones::dynamic();
+        op["op"]   = "remove";
+        op["path"] = "/nested/c~0d";
+        patch.push_back(op);
+
+        op          = njones::dynamic();
+        op["op"]    = "test";
+        op["path"]  = "/title";
+        op["value"] = "widget";
+        patch.push_back(op);
+
+        op          = njones::dynamic();
+        op["op"]    = "test";
+        op["path"]  = "/count";
+        op["value"] = 3.0;
+        patch.push_back(op);
+
+        op["value"] = 3UL;
+        patch.push_back(op);
+
+        d.apply_patch(patch);
+        TS_ASSERT(d["tags"].size() == 5);
+        TS_ASSERT(d["tags"][0].as_string() == "first");
+        TS_ASSERT(d["tags"][4].as_int() == 3);
+        TS_ASSERT(d["nested"]["a/b"].as_int() == 5);
+        TS_ASSERT(!d["nested"].has("c~d"));
+        TS_ASSERT(!d.has("name"));
+        TS_ASSERT(d["title"].as_string() == "widget");
+    }
+
+    void test_apply_errors() {
+        njones::dynamic d = make_document();
+        njones::dynamic patch(njones::dynamic::type::ARRAY);
+        njones::dynamic op;
+        op["op"]    = "test";
+        op["path"]  = "/count";
+        op["value"] = 4;
+        patch.push_back(op);
+        try {
+            d.apply_patch(patch);
+            TS_ASSERT(false);
+        } catch (const domain_error &e) {
+            TS_ASSERT(true);
+        }
+
+        patch.clear();
+        op          = njones::dynamic();
+        op["op"]    = "replace";
+        op["path"]  = "/missing";
+        op["value"] = 4;
+        patch.push_back(op);
+        try {
+            d.apply_patch(patch);
+            TS_ASSERT(false);
+        } catch (const range_error &e) {
+            TS_ASSERT(true);
+        }
+    }
+
+    void test_merge_patch() {
+        njones::dynamic d      = make_document();
+        njones::dynamic nested = d["nested"];
+
+        njones::dynamic patch;
+        patch["name"]          = nullptr;
+        patch["count"]         = 7;
+        patch["nested"]["c~d"] = nullptr;
+        patch["nested"]["e"]   = "f";
+        patch["fresh"]["keep"] = 1;
+        patch["fresh"]["drop"] = nullptr;
+        patch["tags"]          = "replaced";
+        d.merge_patch(move(patch));
+
+        TS_ASSERT(!d.has("name"));
+        TS_ASSERT(d["count"].as_int() == 7);
+        TS_ASSERT(d["tags"].as_string() == "replaced");
+        TS_ASSERT(d["nested"].size() == 2);
+        TS_ASSERT(d["nested"]["e"].as_string() == "f");
+        TS_ASSERT(nested.has("e"));
+        TS_ASSERT(d["fresh"].size() == 1);
+        TS_ASSERT(d["fresh"]["keep"].as_int() == 1);
+
+        njones::dynamic shared;
+        shared["layer"]["value"] = 1;
+        njones::dynamic handle = shared;
+        njones::dynamic target;
+        target.merge_patch(move(handle));
+        TS_ASSERT(shared["layer"]["value"].as_int() == 1);
+        TS_ASSERT(target["layer"]["value"].as_int() == 1);
+
+        njones::dynamic scalar = 5;
+        target.merge_patch(move(scalar));
+        TS_ASSERT(target.is_int());
+        scalar = "reused";
+        TS_ASSERT(target.as_int() == 5);
+
+        njones::dynamic owned;
+        owned["a"]["b"] = 1;
+        owned["c"]      = 2;
+        njones::dynamic merged;
+        merged.merge_patch(move(owned));
+        TS_ASSERT(owned.empty());
+        TS_ASSERT(owned.str() == "{}");
+        owned["a"] = "new";
+        TS_ASSERT(merged["a"]["b"].as_int() == 1);
+        TS_ASSERT(merged["c"].as_int() == 2);
+    }
+};
@@ -0,0 +1,109 @@
+#include <cxxtest/TestSuite.h>
+#include <vector>
+
+#include "dynamic.hpp"
+#include "pointer.hpp"
+
+using namespace std;
+
+class pointer_test_suite : public CxxTest::TestSuite {
+   public:
+    njones::dynamic make_document() {
+        njones::dynamic d;
+        d["payload"]["items"].set_type(njones::dynamic::type::ARRAY);
+        njones::dynamic item;
+        item["price"] = 9.5;
+        d["payload"]["items"].push_back(item);
+        d["payload"]["a/b"] = 1;
+        d["payload"]["m~n"] = 2;
+        d["counts"][3]      = "three";
+        return d;
+    }
+
+    void test_get() {
+        njones::dynamic          d = make_document();
+        njones::dynamic::pointer price("/payload/items/0/price");
+        TS_ASSERT(price.size() == 4);
+        TS_ASSERT(price.get(d).as_double() == 9.5);
+        TS_ASSERT(njones::dynamic::pointer("/payload/a~1b").get(d).as_int() == 1);
+        TS_ASSERT(njones::dynamic::pointer("/payload/m~0n").get(d).as_int() == 2);
+        TS_ASSERT(njones::dynamic::pointer("/counts/3").get(d).as_string() == "three");
+        TS_ASSERT(&njones::dynamic::pointer("").get(d) == &d);
+        try {
+            njones::dynamic::pointer("/payload/items/1").get(d);
+            TS_ASSERT(false);
+        } catch (const range_error &e) {
+            TS_ASSERT(true);
+        }
+        try {
+            njones::dynamic::pointer("payload");
+            TS_ASSERT(false);
+        } catch (const domain_error &e) {
+            TS_ASSERT(true);
+        }
+    }
+
+    void test_contains() {
+        njones::dynamic d = make_document();
+        TS_ASSERT(njones::dynamic::pointer("/payload/items/0").contains(d));
+        TS_ASSERT(!njones::dynamic::pointer("/payload/items/01").contains(d));
+        TS_ASSERT(!njones::dynamic::pointer("/payload/missing/x").contains(d));
+        TS_ASSERT(!njones::dynamic::pointer("/payload/items/0/price/x").contains(d));
+    }
+
+    void test_set() {
+        njones::dynamic d = make_document();
+        njones::dynamic::pointer("/payload/items/0/price").set(d, 10);
+        TS_ASSERT(d["payload"]["items"][0]["price"].as_int() == 10);
+        njones::dynamic::pointer("/payload/items/-").set(d, "appended");
+        TS_ASSERT(d["payload"]["items"].size() == 2);
+        TS_ASSERT(d["payload"]["items"][1].as_string() == "appended");
+        njones::dynamic::pointer("/new/deep/key").set(d, true);
+        TS_ASSERT(d["new"]["deep"]["key"].as_bool() == true);
+        try {
+            njones::dynamic::pointer("/payload/items/5").set(d, 1);
+            TS_ASSERT(false);
+        } catch (const range_error &e) {
+            TS_ASSERT(true);
+        }
+    }
+
+    void test_erase() {
+        njones::dynamic d = make_document();
+        njones::dynamic::pointer("/payload/a~1b").erase(d);
+        TS_ASSERT(!d["payload"].has("a/b"));
+        njones::dynamic::pointer("/payload/items/0").erase(d);
+        TS_ASSERT(d["payload"]["items"].empty());
+        njones::dynamic::pointer("/counts/3").erase(d);
+        TS_ASSERT(d["counts"].empty());
+        try {
+            njones::dynamic::pointer("/payload/missing").erase(d);
+            TS_ASSERT(false);
+        } catch (const range_error &e) {
+            TS_ASSERT(true);
+        }
+    }
+
+    void test_parent_and_append() {
+        njones::dynamic::pointer p("/payload/items/0");
+        TS_ASSERT(p.parent().str() == "/payload/items");
+        TS_ASSERT(p.back() == "0");
+        TS_ASSERT(p.parent().append("a/b").str() == "/payload/items/a~1b");
+        TS_ASSERT(p.parent().append(3).str() == "/payload/items/3");
+    }
+
+    void test_resolve_batch() {
+        njones::dynamic                  d = make_document();
+        vector<njones::dynamic::pointer> pointers{"/payload/items/0/price", "/payload/missing",
+                                                  "/payload/a~1b", "/counts/3",
+                                                  "/payload/items/0"};
+        vector<const njones::dynamic *>  out;
+        njones::dynamic::pointer::resolve(d, pointers, out);
+        TS_ASSERT(out.size() == 5);
+        TS_ASSERT(out[0]->as_double() == 9.5);
+        TS_ASSERT(out[1] == nullptr);
+        TS_ASSERT(out[2]->as_int() == 1);
+        TS_ASSERT(out[3]->as_string() == "three");
+        TS_ASSERT(out[4] == &d["payload"]["items"][0]);
+    }
+};
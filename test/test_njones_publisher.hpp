@@ -0,0 +1,95 @@
+#include <cxxtest/TestSuite.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "dynamic.hpp"
+#include "publisher.hpp"
+
+using namespace std;
+
+class publisher_test_suite : public CxxTest::TestSuite {
+   public:
+    njones::dynamic make_config(const int generation) {
+        njones::dynamic d;
+        d["generation"] = generation;
+        d["name"]       = "config";
+        return d;
+    }
+
+    void test_publish_snapshot() {
+        njones::dynamic_publisher publisher(make_config(1));
+        njones::dynamic_snapshot  first = publisher.snapshot();
+        TS_ASSERT(first->at("generation").as_int() == 1);
+        TS_ASSERT(first.version() == 1);
+
+        publisher.publish(make_config(2));
+        TS_ASSERT((*first)["generation"].as_int() == 1);
+        TS_ASSERT(publisher.retired() == 1);
+        {
+            njones::dynamic_snapshot second = publisher.snapshot();
+            TS_ASSERT(second.root()["generation"].as_int() == 2);
+            TS_ASSERT(second.version() == 2);
+        }
+
+        njones::dynamic_snapshot moved(move(first));
+        TS_ASSERT(moved->at("name").as_string() == "config");
+        TS_ASSERT(publisher.reclaim() == 0);
+    }
+
+    void test_reclaim() {
+        njones::dynamic_publisher publisher(make_config(1));
+        {
+            njones::dynamic_snapshot held = publisher.snapshot();
+            publisher.publish(make_config(2));
+            publisher.publish(make_config(3));
+            TS_ASSERT(publisher.retired() == 2);
+        }
+        TS_ASSERT(publisher.reclaim() == 2);
+        TS_ASSERT(publisher.retired() == 0);
+        TS_ASSERT(publisher.snapshot()->at("generation").as_int() == 3);
+    }
+
+    void test_exhausted_slots() {
+        njones::dynamic_publisher publisher(make_config(1), 1);
+        njones::dynamic_snapshot  held  = publisher.snapshot();
+        njones::dynamic_snapshot  extra = publisher.snapshot();
+        TS_ASSERT(extra->at("generation").as_int() == 1);
+
+        publisher.publish(make_config(2));
+        njones::dynamic_snapshot latest = publisher.snapshot();
+        TS_ASSERT(latest->at("generation").as_int() == 2);
+        TS_ASSERT(latest.version() == 2);
+        TS_ASSERT(held->at("generation").as_int() == 1);
+
+        njones::dynamic_snapshot moved(move(extra));
+        publisher.publish(make_config(3));
+        TS_ASSERT(moved->at("generation").as_int() == 1);
+        TS_ASSERT(moved.version() == 1);
+    }
+
+    void test_concurrent_readers() {
+        njones::dynamic_publisher publisher(make_config(0), 8);
+        atomic<bool>              stop(false);
+        atomic<int>               errors(0);
+        vector<thread>            readers;
+        for (int t = 0; t < 4; t++)
+            readers.emplace_back([&] {
+                int last = 0;
+                while (!stop) {
+                    njones::dynamic_snapshot s = publisher.snapshot();
+                    const int generation       = s->at("generation").as_int();
+                    if (generation < last || s->at("name").as_string() != "config")
+                        errors++;
+                    last = generation;
+                }
+            });
+        for (int i = 1; i <= 200; i++)
+            publisher.publish(make_config(i));
+        stop = true;
+        for (thread &t : readers)
+            t.join();
+        TS_ASSERT(errors == 0);
+        TS_ASSERT(publisher.snapshot()->at("generation").as_int() == 200);
+    }
+};
@@ -0,0 +1,104 @@
+#include <cxxtest/TestSuite.h>
+#include <cstdio>
+#include <fstream>
+#include <limits>
+
+#include "dynamic.hpp"
+#include "snapshot.hpp"
+
+using namespace std;
+
+class snapshot_test_suite : public CxxTest::TestSuite {
+   public:
+    njones::dynamic make_document() {
+        njones::dynamic d;
+        d["int"]    = -42;
+        d["ulong"]  = numeric_limits<unsigned long>::max();
+        d["double"] = 1.25;
+        d["bool"]   = true;
+        d["null"]   = nullptr;
+        d["string"] = "a string";
+        d["array"].set_type(njones::dynamic::type::ARRAY);
+        d["array"].push_back(1);
+        d["array"].push_back("two");
+        d["map"]["nested"] = "value";
+        d[7]               = "seven";
+        return d;
+    }
+
+    void test_view_navigation() {
+        const string       snapshot = make_document().save_snapshot();
+        njones::dynamic_view view(snapshot.data(), snapshot.size());
+        TS_ASSERT(view.is_map());
+        TS_ASSERT(view.size() == 9);
+        TS_ASSERT(view["int"].as_int() == -42);
+        TS_ASSERT(view["int"].is_int());
+        TS_ASSERT(view["ulong"].as_ulong() == numeric_limits<unsigned long>::max());
+        TS_ASSERT(view["double"].as_double() == 1.25);
+        TS_ASSERT(view["bool"].as_bool() == true);
+        TS_ASSERT(view["null"].is_null());
+        TS_ASSERT(string(view["string"].c_str()) == "a string");
+        TS_ASSERT(view["string"].size() == 8);
+        TS_ASSERT(view["array"].size() == 2);
+        TS_ASSERT(view["array"][1].as_string() == "two");
+        TS_ASSERT(view.at("map").at("nested").as_string() == "value");
+        TS_ASSERT(view.has("map"));
+        TS_ASSERT(!view.has("missing"));
+        try {
+            view["missing"];
+            TS_ASSERT(false);
+        } catch (const range_error &e) {
+            TS_ASSERT(true);
+        }
+        try {
+            view["array"][2];
+            TS_ASSERT(false);
+        } catch (const range_error &e) {
+            TS_ASSERT(true);
+        }
+    }
+
+    void test_view_to_dynamic() {
+        njones::dynamic      d        = make_document();
+        const string         snapshot = d.save_snapshot();
+        njones::dynamic_view view(snapshot.data(), snapshot.size());
+        njones::dynamic      copy = view.to_dynamic();
+        TS_ASSERT(copy.size() == d.size());
+        TS_ASSERT(copy["array"] == d["array"]);
+        TS_ASSERT(copy[7].as_string() == "seven");
+        TS_ASSERT(copy["ulong"].is_ulong());
+    }
+
+    void test_mapped_snapshot() {
+        const string path = "test_njones_snapshot.bin";
+        {
+            ofstream out(path, ios::binary);
+            make_document().save_snapshot(out);
+        }
+        {
+            njones::mapped_snapshot mapped(path);
+            njones::dynamic_view    root = mapped.root();
+            TS_ASSERT(root["map"]["nested"].as_string() == "value");
+            TS_ASSERT(root["array"][0].as_int() == 1);
+        }
+        remove(path.c_str());
+    }
+
+    void test_invalid_snapshot() {
+        const string garbage = "not a snapshot at all, really";
+        try {
+            njones::dynamic_view view(garbage.data(), garbage.size());
+            TS_ASSERT(false);
+        } catch (const domain_error &e) {
+            TS_ASSERT(true);
+        }
+        string snapshot = make_document().save_snapshot();
+        snapshot.resize(snapshot.size() / 2);
+        try {
+            njones::dynamic_view view(snapshot.data(), snapshot.size());
+            TS_ASSERT(false);
+        } catch (const range_error &e) {
+            TS_ASSERT(true);
+        }
+    }
+};
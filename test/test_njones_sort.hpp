@@ -0,0 +1,95 @@
+#include <cxxtest/TestSuite.h>
+#include <limits>
+
+#include "dynamic.hpp"
+#include "pointer.hpp"
+
+using namespace std;
+
+class sort_test_suite : public CxxTest::TestSuite {
+   public:
+    void test_compare() {
+        TS_ASSERT(njones::dynamic::compare(9, 10) < 0);
+        TS_ASSERT(njones::dynamic::compare(1, 1L) == 0);
+        TS_ASSERT(njones::dynamic::compare(1, 1.5) < 0);
+        TS_ASSERT(njones::dynamic::compare(-1, numeric_limits<unsigned long>::max()) < 0);
+        TS_ASSERT(njones::dynamic::compare(nullptr, false) < 0);
+        TS_ASSERT(njones::dynamic::compare(true, 0) < 0);
+        TS_ASSERT(njones::dynamic::compare(100, "1") < 0);
+        TS_ASSERT(njones::dynamic::compare("abc", "abd") < 0);
+        TS_ASSERT(njones::dynamic::compare("b", "abc") > 0);
+    }
+
+    void test_sort_numbers() {
+        njones::dynamic d(njones::dynamic::type::ARRAY);
+        d.push_back(10);
+        d.push_back(9);
+        d.push_back(-3);
+        d.push_back(100);
+        d.push_back(0);
+        d.sort();
+        TS_ASSERT(d[0].as_int() == -3);
+        TS_ASSERT(d[1].as_int() == 0);
+        TS_ASSERT(d[2].as_int() == 9);
+        TS_ASSERT(d[3].as_int() == 10);
+        TS_ASSERT(d[4].as_int() == 100);
+
+        njones::dynamic f(njones::dynamic::type::ARRAY);
+        f.push_back(2.5);
+        f.push_back(-0.5);
+        f.push_back(-10.0);
+        f.push_back(1e10);
+        f.sort();
+        TS_ASSERT(f[0].as_double() == -10.0);
+        TS_ASSERT(f[1].as_double() == -0.5);
+        TS_ASSERT(f[3].as_double() == 1e10);
+    }
+
+    void test_sort_strings() {
+        njones::dynamic d(njones::dynamic::type::ARRAY);
+        d.push_back("pear");
+        d.push_back("apple pie");
+        d.push_back("apple");
+        d.push_back("apple crumble");
+        d.push_back("");
+        d.sort();
+        TS_ASSERT(d[0].as_string() == "");
+        TS_ASSERT(d[1].as_string() == "apple");
+        TS_ASSERT(d[2].as_string() == "apple crumble");
+        TS_ASSERT(d[3].as_string() == "apple pie");
+        TS_ASSERT(d[4].as_string() == "pear");
+    }
+
+    void test_sort_mixed() {
+        njones::dynamic d(njones::dynamic::type::ARRAY);
+        d.push_back("text");
+        d.push_back(2.5);
+        d.push_back(nullptr);
+        d.push_back(3);
+        d.push_back(true);
+        d.sort();
+        TS_ASSERT(d[0].is_null());
+        TS_ASSERT(d[1].is_bool());
+        TS_ASSERT(d[2].as_double() == 2.5);
+        TS_ASSERT(d[3].as_int() == 3);
+        TS_ASSERT(d[4].is_string());
+    }
+
+    void test_stable_sort_key() {
+        njones::dynamic d(njones::dynamic::type::ARRAY);
+        const char *    names[] = {"a", "b", "c", "d", "e"};
+        const int       ages[]  = {30, 20, 30, 20, 10};
+        for (size_t i = 0; i < 5; i++) {
+            njones::dynamic item;
+            item["name"] = names[i];
+            item["age"]  = ages[i];
+            d.push_back(item);
+        }
+        d.stable_sort(njones::dynamic::pointer("/age"));
+        TS_ASSERT(d[0]["name"].as_string() == "e");
+        TS_ASSERT(d[1]["name"].as_string() == "b");
+        TS_ASSERT(d[2]["name"].as_string() == "d");
+        TS_ASSERT(d[3]["name"].as_string() == "a");
+        TS_ASSERT(d[4]["name"].as_string() == "c");
+    }
+};
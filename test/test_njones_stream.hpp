@@ -0,0 +1,198 @@
+#include <cxxtest/TestSuite.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <fstream>
+#include <sstream>
+
+#include "dynamic.hpp"
+#include "stream.hpp"
+
+using namespace std;
+
+class stream_test_suite : public CxxTest::TestSuite {
+   public:
+    njones::dynamic make_document() {
+        njones::dynamic d;
+        d["name"]   = "stream \"test\"\n\ttab";
+        d["empty"]  = njones::dynamic(njones::dynamic::type::ARRAY);
+        d["object"] = njones::dynamic();
+        d["ratio"]  = 0.1;
+        d["flag"]   = false;
+        d["none"]   = njones::dynamic(njones::dynamic::type::NONE);
+        d["large"]  = 1UL << 40;
+        d["ints"]   = njones::dynamic(njones::dynamic::type::ARRAY);
+        d["ints"].assign(std::vector<int>({3, -7, 11}).data(), 3);
+        d["reals"]  = njones::dynamic(njones::dynamic::type::ARRAY);
+        d["reals"].assign(std::vector<double>({0.5, -1e21, 3.25}).data(), 3);
+        d["rows"] = njones::dynamic(njones::dynamic::type::ARRAY);
+        for (int i = 0; i < 2000; i++) {
+            njones::dynamic row;
+            row["id"]          = i;
+            row["score"]       = i * 1.5;
+            row["nested"]["x"] = njones::dynamic(njones::dynamic::type::ARRAY);
+            row["nested"]["x"].push_back(i);
+            d["rows"].push_back(row);
+        }
+        return d;
+    }
+
+    void test_callback_sink() {
+        const njones::dynamic d = make_document();
+        for (const bool pretty : {false, true}) {
+            std::string         out;
+            std::vector<size_t> sizes;
+            {
+                njones::callback_sink  sink([&out, &sizes](const char *data, size_t size) {
+                    out.append(data, size);
+                    sizes.push_back(size);
+                });
+                njones::dynamic_stream stream(sink, 1024);
+                stream.write(d, pretty);
+                stream.flush();
+                TS_ASSERT(stream.written() == out.size());
+            }
+            TS_ASSERT(out == d.str(pretty));
+            TS_ASSERT(sizes.size() > 1);
+            for (size_t i = 0; i + 1 < sizes.size(); i++)
+                TS_ASSERT(sizes[i] == 1024);
+            TS_ASSERT(sizes.back() <= 1024);
+        }
+
+        for (const njones::dynamic &d : {njones::dynamic(njones::dynamic::type::ARRAY),
+                                         njones::dynamic(), njones::dynamic(42),
+                                         njones::dynamic("text")}) {
+            std::string            out;
+            njones::callback_sink  sink([&out](const char *data, size_t size) {
+                out.append(data, size);
+            });
+            njones::dynamic_stream stream(sink);
+            stream.write(d, true);
+            stream.flush();
+            TS_ASSERT(out == d.str(true));
+        }
+    }
+
+    void test_fd_sinks() {
+        const njones::dynamic d = make_document();
+        for (const bool vectored : {false, true}) {
+            char      path[] = "/tmp/njones_streamXXXXXX";
+            const int fd     = mkstemp(path);
+            TS_ASSERT(fd >= 0);
+            {
+                njones::fd_sink        plain(fd);
+                njones::writev_sink    batched(fd, 4);
+                njones::dynamic_stream stream(vectored ? static_cast<njones::dynamic_sink &>(batched)
+                                                       : plain,
+                                              512);
+                stream.write(d, true);
+                stream.flush();
+            }
+            close(fd);
+
+            std::ifstream     file(path);
+            std::stringstream contents;
+            contents << file.rdbuf();
+            TS_ASSERT(contents.str() == d.str(true));
+            unlink(path);
+        }
+
+        try {
+            njones::fd_sink sink(-1);
+            sink.write("x", 1);
+            TS_ASSERT(false);
+        } catch (const std::system_error &e) {
+            TS_ASSERT(true);
+        }
+    }
+
+    void test_writer() {
+        const njones::dynamic d = make_document();
+        for (const bool pretty : {false, true}) {
+            std::string out;
+            {
+                njones::dynamic_writer w(out, pretty);
+                w.begin_object();
+                for (const auto item : d) {
+                    w.key(item.key().as_string());
+                    if (item.key() == "rows") {
+                        w.begin_array();
+                        for (const auto row : item.value()) {
+                            const njones::dynamic &r = row.value();
+                            w.begin_object();
+                            for (const auto field : r) {
+                                w.key(field.key().as_string());
+                                if (field.key() == "id")
+                                    w.value(field.value().as_int());
+                                else if (field.key() == "score")
+                                    w.value(field.value().as_double());
+                                else
+                                    w.write(field.value());
+                            }
+                            w.end_object();
+                        }
+                        w.end_array();
+                    } else
+                        w.write(item.value());
+                }
+                w.end_object();
+                TS_ASSERT(w.complete());
+                TS_ASSERT(w.depth() == 0);
+            }
+            TS_ASSERT(out == d.str(pretty));
+        }
+
+        std::string out;
+        {
+            njones::dynamic_writer w(out);
+            w.begin_array().value(1).value(2UL).value(true).null().value("x\"y");
+            w.begin_object().end_object().begin_array().end_array().end_array();
+        }
+        njones::dynamic expected(njones::dynamic::type::ARRAY);
+        expected.push_back(1);
+        expected.push_back(2UL);
+        expected.push_back(true);
+        expected.push_back(njones::dynamic(njones::dynamic::type::NONE));
+        expected.push_back("x\"y");
+        expected.push_back(njones::dynamic());
+        expected.push_back(njones::dynamic(njones::dynamic::type::ARRAY));
+        TS_ASSERT(out == expected.str());
+    }
+
+    void test_writer_nesting() {
+        std::string            out;
+        njones::dynamic_writer w(out);
+        try {
+            w.key("a");
+            TS_ASSERT(false);
+        } catch (const domain_error &e) {
+            TS_ASSERT(true);
+        }
+        w.begin_object();
+        try {
+            w.value(1);
+            TS_ASSERT(false);
+        } catch (const domain_error &e) {
+            TS_ASSERT(true);
+        }
+        try {
+            w.end_array();
+            TS_ASSERT(false);
+        } catch (const domain_error &e) {
+            TS_ASSERT(true);
+        }
+        w.key("a");
+        try {
+            w.end_object();
+            TS_ASSERT(false);
+        } catch (const domain_error &e) {
+            TS_ASSERT(true);
+        }
+        w.value(1).end_object();
+        try {
+            w.value(2);
+            TS_ASSERT(false);
+        } catch (const domain_error &e) {
+            TS_ASSERT(true);
+        }
+    }
+};
@@ -0,0 +1,124 @@
+#include <cxxtest/TestSuite.h>
+#include <limits>
+
+#include "dynamic.hpp"
+#include "tape.hpp"
+
+using namespace std;
+
+class tape_test_suite : public CxxTest::TestSuite {
+   public:
+    njones::dynamic make_document() {
+        njones::dynamic d;
+        d["int"]    = -42;
+        d["ulong"]  = numeric_limits<unsigned long>::max();
+        d["double"] = 1.25;
+        d["bool"]   = false;
+        d["null"]   = nullptr;
+        d["string"] = "a string";
+        d["array"].set_type(njones::dynamic::type::ARRAY);
+        d["array"].push_back(1);
+        d["array"].push_back("two");
+        d["array"].push_back(3.5);
+        d["map"]["nested"]["deeper"] = "value";
+        return d;
+    }
+
+    void test_tape_access() {
+        njones::dynamic_tape tape(make_document());
+        njones::tape_value   root = tape.root();
+        TS_ASSERT(root.is_map());
+        TS_ASSERT(root.size() == 8);
+        TS_ASSERT(root["int"].as_int() == -42);
+        TS_ASSERT(root["ulong"].as_ulong() == numeric_limits<unsigned long>::max());
+        TS_ASSERT(root["double"].as_double() == 1.25);
+        TS_ASSERT(root["bool"].is_bool());
+        TS_ASSERT(root["bool"].as_bool() == false);
+        TS_ASSERT(root["null"].is_null());
+        TS_ASSERT(root["string"].as_string() == "a string");
+        TS_ASSERT(tape["array"].size() == 3);
+        TS_ASSERT(tape["array"][1].as_string() == "two");
+        TS_ASSERT(tape["array"].back().as_double() == 3.5);
+        TS_ASSERT(root.at("map").at("nested").at("deeper").as_string() == "value");
+        TS_ASSERT(root.has("map"));
+        TS_ASSERT(!root.has("missing"));
+        try {
+            root["missing"];
+            TS_ASSERT(false);
+        } catch (const range_error &e) {
+            TS_ASSERT(true);
+        }
+        try {
+            root["int"][0];
+            TS_ASSERT(false);
+        } catch (const domain_error &e) {
+            TS_ASSERT(true);
+        }
+    }
+
+    void test_tape_iteration() {
+        njones::dynamic_tape tape(make_document());
+        size_t               count = 0;
+        for (const auto item : tape.root()) {
+            TS_ASSERT(item.key().is_string());
+            count++;
+        }
+        TS_ASSERT(count == 8);
+
+        double sum = 0;
+        for (const auto item : tape["array"])
+            if (!item.value().is_string())
+                sum += item.value().as_double();
+        TS_ASSERT(sum == 4.5);
+    }
+
+    void test_tape_skip() {
+        njones::dynamic_tape tape(make_document());
+        njones::tape_value   map = tape["map"];
+        TS_ASSERT(map.next() > map["nested"].next());
+        TS_ASSERT(map.next() == map["nested"].next() + 1);
+    }
+
+    void test_tape_indexed_lookup() {
+        njones::dynamic d;
+        d["list"].set_type(njones::dynamic::type::ARRAY);
+        for (int i = 0; i < 1000; i++) {
+            d["list"].push_back(i % 3 == 0 ? njones::dynamic(i) : njones::dynamic(to_string(i)));
+            d["key" + to_string(i)] = i;
+        }
+        d["k"]  = "short";
+        d[7]    = "not a string key";
+        d["k7"] = "prefix";
+
+        njones::dynamic_tape tape(d);
+        njones::tape_value   list = tape["list"];
+        TS_ASSERT(list.size() == 1000);
+        TS_ASSERT(list[0].as_int() == 0);
+        TS_ASSERT(list[998].as_string() == "998");
+        TS_ASSERT(list[999].as_int() == 999);
+        for (int i = 0; i < 1000; i++)
+            TS_ASSERT(tape["key" + to_string(i)].as_int() == i);
+        TS_ASSERT(tape["k"].as_string() == "short");
+        TS_ASSERT(tape["k7"].as_string() == "prefix");
+        TS_ASSERT(!tape.root().has("key"));
+        TS_ASSERT(!tape.root().has("7"));
+        TS_ASSERT(!tape.root().has("key1000"));
+        try {
+            list[1000];
+            TS_ASSERT(false);
+        } catch (const range_error &e) {
+            TS_ASSERT(true);
+        }
+    }
+
+    void test_tape_round_trip() {
+        njones::dynamic      d = make_document();
+        njones::dynamic_tape tape(d);
+        njones::dynamic      copy = tape.to_dynamic();
+        TS_ASSERT(copy.size() == d.size());
+        TS_ASSERT(copy["array"] == d["array"]);
+        TS_ASSERT(copy["map"] == d["map"]);
+        TS_ASSERT(copy["ulong"].is_ulong());
+        TS_ASSERT(tape["array"].str() == d["array"].str());
+    }
+};
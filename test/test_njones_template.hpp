@@ -0,0 +1,120 @@
+#include <cxxtest/TestSuite.h>
+
+#include "dynamic.hpp"
+#include "template.hpp"
+
+using namespace std;
+
+class template_test_suite : public CxxTest::TestSuite {
+   public:
+    void test_render() {
+        njones::dynamic skeleton;
+        skeleton["status"]          = "ok";
+        skeleton["id"]              = "{{id:long}}";
+        skeleton["user"]["name"]    = "{{name:string}}";
+        skeleton["user"]["profile"] = "{{profile}}";
+        skeleton["echo"]            = "{{id:long}}";
+        skeleton["ratio"]           = "{{ratio:double}}";
+        skeleton["flags"]           = njones::dynamic(njones::dynamic::type::ARRAY);
+        skeleton["flags"].push_back("{{active:bool}}");
+        skeleton["flags"].push_back("{not a slot}");
+
+        njones::dynamic profile;
+        profile["age"]  = 31;
+        profile["tags"] = njones::dynamic(njones::dynamic::type::ARRAY);
+        profile["tags"].push_back("x");
+
+        for (const bool pretty : {false, true}) {
+            const njones::dynamic_template t(skeleton, pretty);
+            TS_ASSERT(t.size() == 5);
+            TS_ASSERT(t.typed(t.slot("id")));
+            TS_ASSERT(t.type(t.slot("id")) == njones::dynamic::type::LONG);
+            TS_ASSERT(!t.typed(t.slot("profile")));
+
+            njones::dynamic values;
+            values["id"]      = 42L;
+            values["name"]    = "Ada \"L\"";
+            values["profile"] = profile;
+            values["ratio"]   = 0.25;
+            values["active"]  = true;
+
+            njones::dynamic expected = skeleton.deep_copy();
+            expected["id"]           = 42L;
+            expected["echo"]         = 42L;
+            expected["user"]["name"]    = "Ada \"L\"";
+            expected["user"]["profile"] = profile;
+            expected["ratio"]           = 0.25;
+            expected["flags"][0]        = true;
+            TS_ASSERT(t.render(values) == expected.str(pretty));
+
+            std::vector<njones::dynamic> ordered(t.size());
+            for (size_t i = 0; i < t.size(); i++)
+                ordered[i] = values[t.name(i)];
+            TS_ASSERT(t.render(ordered) == expected.str(pretty));
+        }
+
+        njones::dynamic root("{{value}}");
+        TS_ASSERT(njones::dynamic_template(root).render(std::vector<njones::dynamic>{7}) == "7");
+    }
+
+    void test_errors() {
+        njones::dynamic skeleton;
+        skeleton["name"] = "{{name:string}}";
+        const njones::dynamic_template t(skeleton);
+        try {
+            t.render(std::vector<njones::dynamic>());
+            TS_ASSERT(false);
+        } catch (const range_error &e) {
+            TS_ASSERT(true);
+        }
+        try {
+            t.render(std::vector<njones::dynamic>{1});
+            TS_ASSERT(false);
+        } catch (const domain_error &e) {
+            TS_ASSERT(true);
+        }
+        try {
+            t.slot("missing");
+            TS_ASSERT(false);
+        } catch (const range_error &e) {
+            TS_ASSERT(true);
+        }
+
+        njones::dynamic bad;
+        bad["x"] = "{{x:complex}}";
+        try {
+            njones::dynamic_template b(bad);
+            TS_ASSERT(false);
+        } catch (const domain_error &e) {
+            TS_ASSERT(true);
+        }
+        bad["x"] = "{{x:int}}";
+        bad["y"] = "{{x:string}}";
+        try {
+            njones::dynamic_template b(bad);
+            TS_ASSERT(false);
+        } catch (const domain_error &e) {
+            TS_ASSERT(true);
+        }
+
+        njones::dynamic typed;
+        typed["count"] = "{{count:int}}";
+        typed["ratio"] = "{{ratio:double}}";
+        typed["flag"]  = "{{flag:bool}}";
+        const njones::dynamic_template numbers(typed);
+        const std::vector<std::vector<njones::dynamic>> wrong = {
+            {"12", 0.5, true}, {12, "0.5", true}, {12, 0.5, 1}, {12L, 0.5, true}};
+        for (const auto &values : wrong) {
+            std::vector<njones::dynamic> ordered(3);
+            ordered[numbers.slot("count")] = values[0];
+            ordered[numbers.slot("ratio")] = values[1];
+            ordered[numbers.slot("flag")]  = values[2];
+            try {
+                numbers.render(ordered);
+                TS_ASSERT(false);
+            } catch (const domain_error &e) {
+                TS_ASSERT(true);
+            }
+        }
+    }
+};